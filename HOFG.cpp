@@ -2,7 +2,8 @@
 // The code flow is planned as:
 // Iterate on functions : from runOnModule pass
 /*
-Starts with function: generateSummary(Module M)
+Starts with function: traverseCallGraph(Module M), which orders the call graph SCCs bottom-up,
+and summariseCallGraph(), which runs generateFunctionSummary over them from a worklist:
     generates summary for each function with constructHOFGfun(Function F):
     when a call statement in a function occurs:
         applyFunctionSummary handles it:
@@ -17,34 +18,424 @@ Starts with function: generateSummary(Module M)
 #include "llvm/IR/Function.h"
 #include "llvm/IR/Instruction.h"
 #include "llvm/IR/Instructions.h"
+#include "llvm/IR/InstVisitor.h"
+#include "llvm/IR/ModuleSlotTracker.h"
 #include "llvm/IR/Value.h"
 #include "llvm/ADT/SmallSet.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/DenseSet.h"
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/BitVector.h"
+#include "llvm/Support/Allocator.h"
+#include "llvm/ADT/iterator.h"
 #include "llvm/Analysis/CallGraph.h"
+#include "llvm/ADT/SCCIterator.h"
 #include "llvm/IR/Attributes.h"
 #include "llvm/Pass.h"
+#include "llvm/IR/PassManager.h"
+#include "llvm/Passes/PassBuilder.h"
+#include "llvm/Passes/PassPlugin.h"
 #include <llvm/ADT/DepthFirstIterator.h>
 #include "llvm/IR/DebugInfoMetadata.h"
 #include <llvm/ADT/BreadthFirstIterator.h>
 #include "llvm/Support/Casting.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/Threading.h"
+#include "llvm/Support/MD5.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/Process.h"
+#include "llvm/Support/Timer.h"
+#include "llvm/Support/JSON.h"
+#include "llvm/Support/YAMLTraits.h"
+#include "llvm/Config/llvm-config.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/StringExtras.h"
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/ADT/GraphTraits.h"
 #include "llvm/ADT/SmallPtrSet.h"
 #include "llvm/Analysis/CFG.h"
+#include "llvm/Analysis/PostDominators.h"
+#include "llvm/ADT/PostOrderIterator.h"
 #include <utility>
 #include "HOFG.def"
 #include <set>
+#include <algorithm>
+#include <iterator>
+#include <vector>
+#include <cstdint>
 #include <cstdlib>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#ifdef LLVM_ON_UNIX
+#include <sys/resource.h>
+#endif
 using namespace llvm;
 
+//Counted whether or not LLVM is built with statistics, so -hofg-stats reports them from a release build too
+ALWAYS_ENABLED_STATISTIC(NumSummaryCacheHits, "Function summaries replayed from the summary cache");
+ALWAYS_ENABLED_STATISTIC(NumSummaryCacheMisses, "Function summaries built and written to the summary cache");
+ALWAYS_ENABLED_STATISTIC(NumMallocVertices, "HOFG vertices added by addMalloc");
+ALWAYS_ENABLED_STATISTIC(NumMallocFlows, "HOFG flow edges added by addMalloc");
+ALWAYS_ENABLED_STATISTIC(NumDeallocVertices, "HOFG vertices added by addDealloc");
+ALWAYS_ENABLED_STATISTIC(NumDeallocFlows, "HOFG flow edges added by addDealloc");
+ALWAYS_ENABLED_STATISTIC(NumCopyVertices, "HOFG vertices added by addCopy");
+ALWAYS_ENABLED_STATISTIC(NumCopyFlows, "HOFG flow edges added by addCopy");
+ALWAYS_ENABLED_STATISTIC(NumStoreVertices, "HOFG vertices added by addStoreToDereference");
+ALWAYS_ENABLED_STATISTIC(NumStoreFlows, "HOFG flow edges added by addStoreToDereference");
+ALWAYS_ENABLED_STATISTIC(NumPhiVertices, "HOFG vertices added by addPhiInstruction");
+ALWAYS_ENABLED_STATISTIC(NumPhiFlows, "HOFG flow edges added by addPhiInstruction");
+ALWAYS_ENABLED_STATISTIC(NumSummaryVertices, "HOFG vertices added by applyFunctionSummary");
+ALWAYS_ENABLED_STATISTIC(NumSummaryFlows, "HOFG flow edges added by applyFunctionSummary");
+ALWAYS_ENABLED_STATISTIC(NumReturnVertices, "HOFG vertices added by addReturn");
+ALWAYS_ENABLED_STATISTIC(NumReturnFlows, "HOFG flow edges added by addReturn");
+ALWAYS_ENABLED_STATISTIC(NumGepVertices, "HOFG vertices added by addGepToBitcast");
+ALWAYS_ENABLED_STATISTIC(NumGepFlows, "HOFG flow edges added by addGepToBitcast");
+ALWAYS_ENABLED_STATISTIC(NumSummaryPasses, "Function passes of the summary fixpoint");
+ALWAYS_ENABLED_STATISTIC(NumFlowsCanonicalised, "Flow edges erased by canonicalizeHOFG");
+ALWAYS_ENABLED_STATISTIC(NumLeakGraphSCCs, "SCCs of the condensed HOFG of the leak analysis");
+ALWAYS_ENABLED_STATISTIC(NumSourcesClassified, "Obj nodes given a leak verdict");
+ALWAYS_ENABLED_STATISTIC(NumSourcesInconclusive, "Obj nodes left inconclusive by a budget");
+ALWAYS_ENABLED_STATISTIC(NumPathsGenerated, "Paths enumerated from obj nodes");
+ALWAYS_ENABLED_STATISTIC(NumPathsPruned, "Enumerated paths pruned as leakless");
+ALWAYS_ENABLED_STATISTIC(NumScratchAllocations, "Per-source temporaries allocated from the scratch arenas");
+ALWAYS_ENABLED_STATISTIC(NumScratchSlabs, "Slabs the scratch arenas took from malloc");
+static TrackingStatistic *const HOFGStatistics[] = {&NumSummaryCacheHits, &NumSummaryCacheMisses,
+    &NumMallocVertices, &NumMallocFlows, &NumDeallocVertices, &NumDeallocFlows, &NumCopyVertices, &NumCopyFlows,
+    &NumStoreVertices, &NumStoreFlows, &NumPhiVertices, &NumPhiFlows, &NumSummaryVertices, &NumSummaryFlows,
+    &NumReturnVertices, &NumReturnFlows, &NumGepVertices, &NumGepFlows, &NumSummaryPasses, &NumFlowsCanonicalised,
+    &NumLeakGraphSCCs, &NumSourcesClassified, &NumSourcesInconclusive, &NumPathsGenerated, &NumPathsPruned,
+    &NumScratchAllocations, &NumScratchSlabs};
+
+static cl::opt<unsigned> HOFGThreads("hofg-threads",
+    cl::desc("Number of threads of the leak analysis, 0 for one per hardware thread"), cl::init(1));
+static cl::opt<std::string> HOFGCacheDir("hofg-cache-dir",
+    cl::desc("Directory of the function summary cache, none if empty"), cl::init(""));
+static cl::opt<std::string> HOFGSaveGraph("hofg-save-graph",
+    cl::desc("Write the pruned HOFG and the function summaries to this file for -hofg-load-graph"), cl::init(""));
+static cl::opt<std::string> HOFGLoadGraph("hofg-load-graph",
+    cl::desc("Run the leak analysis on a graph written by -hofg-save-graph instead of the input module"), cl::init(""));
+static cl::opt<bool> HOFGWitnessPaths("hofg-witness-paths",
+    cl::desc("Print a witness path of every allocation reported as a leak, the first enumerated path that is not leakless"), cl::init(false));
+static cl::opt<unsigned> HOFGSourceEdges("hofg-source-edges",
+    cl::desc("Edges the leak analysis may visit from one allocation, 0 for no limit"), cl::init(0));
+static cl::opt<unsigned> HOFGSourcePaths("hofg-source-paths",
+    cl::desc("Paths enumerated from one allocation for its witness paths, 0 for no limit"), cl::init(1000));
+static cl::opt<unsigned> HOFGSourceTime("hofg-source-time",
+    cl::desc("Milliseconds the leak analysis may spend on one allocation, 0 for no limit"), cl::init(0));
+static cl::opt<unsigned> HOFGEdgeBudget("hofg-edge-budget",
+    cl::desc("Edges the leak analysis may visit from all the allocations together, 0 for no limit"), cl::init(0));
+static cl::opt<unsigned> HOFGDeadline("hofg-deadline",
+    cl::desc("Seconds the whole analysis may take before the remaining allocations are left inconclusive, 0 for no limit"), cl::init(0));
+static cl::opt<unsigned> HOFGMemoryBudget("hofg-memory-budget",
+    cl::desc("Peak resident memory in MiB past which the remaining allocations are left inconclusive, 0 for no limit"), cl::init(0));
+static cl::opt<std::string> HOFGStatsFile("hofg-stats",
+    cl::desc("Write the phase times, peak memory and counters of the analysis to this file as JSON, - for stdout"), cl::init(""));
+static cl::list<std::string> HOFGAllocators("hofg-allocator",
+    cl::desc("Functions returning a new heap object, besides malloc, u_calloc, calloc and realloc"), cl::CommaSeparated);
+static cl::list<std::string> HOFGDeallocators("hofg-deallocator",
+    cl::desc("Functions freeing their first argument, besides free"), cl::CommaSeparated);
+static cl::list<std::string> HOFGAllocatorWrappers("hofg-allocator-wrapper",
+    cl::desc("Defined functions taken as allocators without a summary, besides xmalloc and xcalloc"), cl::CommaSeparated);
+static cl::opt<std::string> HOFGAllocatorFile("hofg-allocator-file",
+    cl::desc("YAML file of more allocators, deallocators and wrappers, as lists under those keys"), cl::init(""));
+
+/*
+Allocator names of -hofg-allocator-file :
+  allocators:   [ my_alloc, pool_get ]
+  deallocators: [ my_free ]
+  wrappers:     [ checked_alloc ]
+*/
+struct AllocatorNames {
+    std::vector<std::string> allocators;
+    std::vector<std::string> deallocators;
+    std::vector<std::string> wrappers;
+};
+namespace llvm {
+namespace yaml {
+template <> struct MappingTraits<AllocatorNames> {
+    static void mapping(IO &io, AllocatorNames &names) {
+        io.mapOptional("allocators", names.allocators);
+        io.mapOptional("deallocators", names.deallocators);
+        io.mapOptional("wrappers", names.wrappers);
+    }
+};
+}
+}
+
 namespace {
+    /*
+    Work-stealing pool for independent tasks numbered 0..n-1. Each worker starts with a contiguous share of the
+    task numbers in its own deque and takes from its back; a worker that runs dry steals from the front of
+    another worker's deque, so a few expensive tasks do not leave the other threads idle.
+    */
+    class WorkStealingPool {
+        struct WorkQueue {
+            std::mutex lock;
+            std::deque<unsigned> tasks;
+        };
+        unsigned numThreads;
+        static bool take(WorkQueue &queue, unsigned &task) {
+            std::lock_guard<std::mutex> guard(queue.lock);
+            if(queue.tasks.empty()) {
+                return false;
+            }
+            task = queue.tasks.back();
+            queue.tasks.pop_back();
+            return true;
+        }
+        static bool steal(std::vector<WorkQueue> &queues, unsigned thief, unsigned &task) {
+            for(unsigned k = 1; k < queues.size(); k++) {
+                WorkQueue &victim = queues[(thief + k) % queues.size()];
+                std::lock_guard<std::mutex> guard(victim.lock);
+                if(!victim.tasks.empty()) {
+                    task = victim.tasks.front();
+                    victim.tasks.pop_front();
+                    return true;
+                }
+            }
+            return false;
+        }
+      public:
+        explicit WorkStealingPool(unsigned threads) : numThreads(threads ? threads : 1) {}
+        unsigned size() const {return numThreads;}
+        //Calls fn(worker, task) for every task below numTasks, worker being the index of the calling thread
+        template <typename TaskFn> void run(unsigned numTasks, TaskFn fn) {
+            if(numThreads == 1 || numTasks < 2) {
+                for(unsigned t = 0; t < numTasks; t++) {
+                    fn(0, t);
+                }
+                return;
+            }
+            std::vector<WorkQueue> queues(numThreads);
+            for(unsigned t = 0; t < numTasks; t++) {
+                queues[(unsigned)((uint64_t)t * numThreads / numTasks)].tasks.push_back(t);
+            }
+            auto work = [&](unsigned worker) {
+                unsigned task;
+                while(take(queues[worker], task) || steal(queues, worker, task)) {
+                    fn(worker, task);
+                }
+            };
+            std::vector<std::thread> threads;
+            for(unsigned w = 1; w < numThreads; w++) {
+                threads.emplace_back(work, w);
+            }
+            work(0);
+            for(std::thread &th : threads) {
+                th.join();
+            }
+        }
+    };
+    /*
+    Memory for the temporaries of one source of the leak analysis, cut from a bump allocator and given back all
+    at once by reset() when the source is done. A block freed before that goes on a free list of its size, so a
+    container cleared and refilled for every path reuses its nodes instead of growing the arena.
+    */
+    class ScratchArena {
+        static constexpr size_t Granule = 16, MaxRecycled = 512;
+        BumpPtrAllocator arena;
+        void *freeBlocks[MaxRecycled / Granule + 1] = {}; //by size in granules, linked through their first word
+        size_t numAllocations = 0;
+        size_t keptSlabs = 0; //the slab Reset keeps
+      public:
+        ScratchArena() = default;
+        ScratchArena(const ScratchArena &) = delete;
+        ScratchArena &operator=(const ScratchArena &) = delete;
+        ~ScratchArena() {reset();}
+        void *allocate(size_t size, size_t align) {
+            numAllocations++;
+            if(size > MaxRecycled || align > Granule) {
+                return arena.Allocate(size, Align(align));
+            }
+            size = alignTo(size, Granule);
+            void *&free = freeBlocks[size / Granule];
+            if(free) {
+                void *block = free;
+                free = *(void**)block;
+                return block;
+            }
+            return arena.Allocate(size, Align(Granule));
+        }
+        void deallocate(void *block, size_t size, size_t align) {
+            if(size <= MaxRecycled && align <= Granule) {
+                size = alignTo(size, Granule);
+                *(void**)block = freeBlocks[size / Granule];
+                freeBlocks[size / Granule] = block;
+            }
+        }
+        void reset() { //Nothing allocated from the arena may be used after this
+            NumScratchAllocations += numAllocations;
+            NumScratchSlabs += arena.GetNumSlabs() - keptSlabs;
+            numAllocations = 0;
+            std::fill(std::begin(freeBlocks), std::end(freeBlocks), nullptr);
+            arena.Reset();
+            keptSlabs = arena.GetNumSlabs();
+        }
+    };
+    template <typename T> struct ScratchAllocator { //Standard allocator over a ScratchArena, for the containers of one source
+        typedef T value_type;
+        ScratchArena *arena;
+        explicit ScratchAllocator(ScratchArena &scratch) : arena(&scratch) {}
+        template <typename U> ScratchAllocator(const ScratchAllocator<U> &other) : arena(other.arena) {}
+        T *allocate(size_t n) {return (T*)arena->allocate(n * sizeof(T), alignof(T));}
+        void deallocate(T *p, size_t n) {arena->deallocate(p, n * sizeof(T), alignof(T));}
+        template <typename U> bool operator==(const ScratchAllocator<U> &other) const {return arena == other.arena;}
+        template <typename U> bool operator!=(const ScratchAllocator<U> &other) const {return arena != other.arena;}
+    };
+    struct ScratchArenaReset { //Resets the arena at the end of the scope, declared before the containers that use it
+        ScratchArena &arena;
+        explicit ScratchArenaReset(ScratchArena &scratch) : arena(scratch) {}
+        ~ScratchArenaReset() {arena.reset();}
+    };
+    /*
+    Prints values as operator<< does. operator<< numbers the whole function of a value again for every value,
+    which is quadratic along a chain of copies in one function; the printer keeps one slot tracker while the
+    values stay in the same function and starts a new one when the function changes, so the slot and
+    metadata numbers are the ones operator<< prints.
+    */
+    class ValuePrinter {
+        const Function *function = nullptr;
+        std::unique_ptr<ModuleSlotTracker> slots;
+        static const Function *functionOf(const Value *value) {
+            if(const Instruction *ins = dyn_cast<Instruction>(value)) {
+                return ins->getFunction();
+            }
+            if(const Argument *arg = dyn_cast<Argument>(value)) {
+                return arg->getParent();
+            }
+            return nullptr;
+        }
+        static const Module *moduleOf(const Value *value) {
+            if(const Function *F = functionOf(value)) {
+                return F->getParent();
+            }
+            if(const GlobalValue *global = dyn_cast<GlobalValue>(value)) {
+                return global->getParent();
+            }
+            return nullptr;
+        }
+      public:
+        void print(const Value *value, raw_ostream &os) {
+            const Function *parent = functionOf(value);
+            if(!slots || parent != function || !parent) {
+                slots.reset(new ModuleSlotTracker(moduleOf(value), isa<MetadataAsValue>(value)));
+                function = parent;
+            }
+            value->print(os, *slots);
+        }
+    };
+    /*
+    Instrumentation of one analysis for -hofg-stats : a timer and the peak resident set size of each phase, and
+    the statistics counted from the start of the analysis, written as one JSON object. The peak is the high-water
+    mark of the process when the phase ends, so it only grows from phase to phase.
+    */
+    class HOFGStats {
+    public:
+        enum phase {summaryPhase, canonicalPhase, endDetectionPhase, pathPhase, numPhases};
+        class Phase { //Times its scope as phase p, nothing if stats is null
+            HOFGStats *stats;
+            phase p;
+            TimeRegion time;
+        public:
+            Phase(HOFGStats *stats, phase p) : stats(stats), p(p), time(stats ? &stats->timers[p] : nullptr) {}
+            ~Phase() {
+                if(stats) {
+                    stats->peakRSS[p] = std::max(stats->peakRSS[p], peakRSSBytes());
+                }
+            }
+        };
+        HOFGStats() : group("hofg", "HOFG analysis phases") {
+            static const char *const names[numPhases][2] = {{"summaries", "Function summary construction"},
+                {"canonicalisation", "HOFG canonicalisation"}, {"endDetection", "Leak facts and end detection"},
+                {"pathGeneration", "Leak reports and witness path generation"}};
+            for(unsigned p = 0; p < numPhases; p++) {
+                timers[p].init(names[p][0], names[p][1], group);
+                peakRSS[p] = 0;
+            }
+            for(TrackingStatistic *statistic : HOFGStatistics) {
+                startValues.push_back(statistic->getValue());
+            }
+        }
+        ~HOFGStats() {
+            group.clear(); //reported in the JSON, not by the timer group when its timers go
+        }
+        static uint64_t peakRSSBytes() { //0 where the platform does not tell
+#ifdef LLVM_ON_UNIX
+            struct rusage usage;
+            if(getrusage(RUSAGE_SELF, &usage) == 0) {
+#ifdef __APPLE__
+                return usage.ru_maxrss;
+#else
+                return (uint64_t)usage.ru_maxrss * 1024;
+#endif
+            }
+#endif
+            return 0;
+        }
+        bool write(StringRef path, StringRef moduleName) const {
+            std::error_code EC;
+            raw_fd_ostream os(path, EC, sys::fs::OF_Text);
+            if(EC) {
+                return false;
+            }
+            json::OStream J(os, 2);
+            J.object([&] {
+                J.attribute("module", moduleName);
+                J.attributeArray("phases", [&] {
+                    for(unsigned p = 0; p < numPhases; p++) {
+                        TimeRecord time = timers[p].getTotalTime();
+                        J.object([&] {
+                            J.attribute("name", timers[p].getName());
+                            J.attribute("description", timers[p].getDescription());
+                            J.attribute("wallSeconds", time.getWallTime());
+                            J.attribute("userSeconds", time.getUserTime());
+                            J.attribute("systemSeconds", time.getSystemTime());
+                            J.attribute("peakRSSBytes", (int64_t)peakRSS[p]);
+                        });
+                    }
+                });
+                J.attributeObject("counters", [&] {
+                    for(size_t i = 0; i < array_lengthof(HOFGStatistics); i++) {
+                        J.attribute(HOFGStatistics[i]->getName(), (int64_t)(HOFGStatistics[i]->getValue() - startValues[i]));
+                    }
+                });
+            });
+            os<<'\n';
+            return true;
+        }
+    private:
+        TimerGroup group;
+        Timer timers[numPhases];
+        uint64_t peakRSS[numPhases];
+        std::vector<uint64_t> startValues;
+    };
 	struct HOFG : public ModulePass {
         static char ID;
-	    HOFG() : ModulePass(ID) {}
+	    HOFG() : ModulePass(ID), Conditions(ownConditions), Locations(ownLocations), allFuncSummaries(ownFuncSummaries), Guards(ownGuards), Plans(ownPlans), Callees(ownCallees) {}
+        //Summary builder of one call graph SCC : its graph is an overlay on the graph of master, and it shares the summaries and conditions
+        explicit HOFG(HOFG &master) : ModulePass(ID), Conditions(master.Conditions), Locations(master.Locations), allFuncSummaries(master.allFuncSummaries), Guards(master.Guards),
+            Plans(master.Plans), Callees(master.Callees) {
+            HeapOFGraph.base = &master.HeapOFGraph;
+        }
         enum vertexType {obj,ptr,snk}; //obj: new heap object, ptr: pointer, snk: free statement
         enum funcType {allocator,deallocator,allocdealloc,noop};//Summary of a function specifies the function type
+        typedef uint32_t VertexId; //Dense index of a vertex in HeapOFGraph
+        typedef uint32_t EdgeId; //Dense index of a flow edge in HeapOFGraph
+        static constexpr uint32_t InvalidId = ~0u;
+        typedef uint32_t CondSetId; //Id of an interned set of branch conditions, 0 is the empty set
+        typedef uint32_t LocId; //Id of an interned debug location, 0 is none
         struct V{ //Data structure to store vertices
             Value *name;
-            vertexType vertexTy;
+            vertexType vertexTy = ptr;
             bool operator < (const V &other) const {return name < other.name;}
             bool operator > (const V &other) const {return name > other.name;}
             bool operator == (const V &other) const {return (name == other.name);}
@@ -52,8 +443,8 @@ namespace {
         struct F { //Data structure to store flow edges
             V head;
             V tail;
-            mutable std::set<Value*> conditions;
-            DebugLoc location;
+            CondSetId conditions = 0; //id in the ConditionSetTable
+            LocId location = 0; //id in the DebugLocTable
             bool operator < (const F &other) const {return ((head < other.head) || (tail < other.tail));}
             bool operator > (const F &other) const {return ((head > other.head) || (tail > other.tail));}
             bool operator == (const F &other) const {return ((head == other.head) && (tail == other.tail) && (conditions==other.conditions));}
@@ -72,198 +463,683 @@ namespace {
             bool operator > (const D &other) const {return ((head > other.head) || (tail > other.tail));}
             bool operator == (const D &other) const {return ((head == other.head) && (tail == other.tail));}
         };
-        struct HOFGraph { //The graph HOFG of the input program is stored in HeapOFGraph
-            std::set<V> vertices;
-            std::set<F> flows;
-            std::set<R> derefs;
-            std::set<D> derived;
-            bool operator == (const HOFGraph &other) const {return ((vertices.size() == other.vertices.size())
-            &&(flows.size() == other.flows.size()));}
-        }HeapOFGraph;
-        struct argTransform {
-            funcType typeOfTransform;
-            int argumentNumber;
-            bool operator < (const argTransform &other) const {return ((typeOfTransform < other.typeOfTransform) 
-            || (argumentNumber < other.argumentNumber));}
+        struct VertexRead {
+            Value *name;
+            bool known;
+            vertexType vertexTy;
         };
-        struct FuncSummary { //Datastructure for storing function summary
-            Function *funcName; //pointer to the function
-            mutable funcType functionType; //Indicate the nature of the function - allocator,deallocator,allocdealloc
-            mutable std::set<Value*> formalArgs; //List of formal arguments to the function
-            mutable std::set<argTransform> argumentTransform;
-            mutable std::list<funcType> argTransforms; //Transformation of arguments : on function execution, if the function allocates or deallocates any location
-            mutable std::set<Value*> globalAlloc;//Variables that have scope outside the function that are being allocated
-            mutable std::set<Value*> globalDealloc;//Variables that have scope outside the function that are being deallocted
-            Type *retType; //return type of the function
-            mutable std::set<Value*> returnValues;
-            bool operator < (const FuncSummary &other) const {return (funcName < other.funcName);}
+        struct FlowRead {
+            Value *tail;
+            Value *head;
+            bool known;
         };
-        struct predBB { //Storing conditins and predecessors
-            BasicBlock *bb;
-            std::set<BasicBlock*> preds;
-            std::set<Value*> entriConditions;
-            bool operator == (const predBB &other) const {return bb == other.bb;}
-            bool operator < (const predBB &other) const {return bb < other.bb;}
+        struct PassRecord { //What one function pass read of the graph as it was before the pass, and what it added
+            bool cacheable = true;
+            std::vector<VertexRead> vertexReads;
+            std::vector<FlowRead> flowReads;
+            DenseSet<Value*> seenVertices, addedVertices;
+            DenseSet<std::pair<Value*,Value*>> seenFlows, addedFlows;
+            std::vector<V> vertices; //vertices the pass put in the graph, including those copied in from base
+            std::vector<F> flows;
         };
-        struct HOFGpath {
-            V start;
-            V end;
-            mutable std::set<F>pathEdge;
-            bool operator == (const HOFGpath &other) const {return ((start == other.start) && (pathEdge == other.pathEdge));}
-            bool operator < (const HOFGpath &other) const {return ((start < other.start) || (pathEdge != other.pathEdge));}
+        /*
+        Condition sets are hash-consed : every distinct set of branch conditions is stored once, sorted,
+        and flow edges and basic blocks hold its id. Union and subset of two sets are memoised by id pair.
+        The members of all the sets are cut from one bump allocator, which lives as long as the table.
+        The table is shared by the summary builders of concurrent SCCs, so every operation takes its lock.
+        */
+        struct ConditionSetTable {
+            BumpPtrAllocator storage; //members of the sets
+            std::vector<ArrayRef<Value*>> sets; //indexed by CondSetId, sets[0] is empty
+            DenseMap<ArrayRef<Value*>, CondSetId> setIds; //keys are the arrays of sets
+            DenseMap<std::pair<CondSetId,CondSetId>, CondSetId> unions;
+            DenseMap<std::pair<CondSetId,CondSetId>, bool> subsets;
+            mutable std::mutex lock;
+            ConditionSetTable() : sets(1) {}
+            CondSetId intern(ArrayRef<Value*> members) { //members have to be sorted and unique
+                std::lock_guard<std::mutex> guard(lock);
+                return internLocked(members);
+            }
+            CondSetId internLocked(ArrayRef<Value*> members) { //A new set is copied into storage
+                if(members.empty()) {
+                    return 0;
+                }
+                auto it = setIds.find(members);
+                if(it != setIds.end()) {
+                    return it->second;
+                }
+                CondSetId id = sets.size();
+                Value **copy = storage.Allocate<Value*>(members.size());
+                std::uninitialized_copy(members.begin(), members.end(), copy);
+                sets.push_back(makeArrayRef(copy, members.size()));
+                setIds[sets.back()] = id;
+                return id;
+            }
+            CondSetId single(Value *cond) {return intern(makeArrayRef(cond));}
+            CondSetId unite(CondSetId a, CondSetId b) {
+                if(a == b || b == 0) {
+                    return a;
+                }
+                if(a == 0) {
+                    return b;
+                }
+                if(a > b) {
+                    std::swap(a, b);
+                }
+                std::lock_guard<std::mutex> guard(lock);
+                auto memo = unions.find(std::make_pair(a, b));
+                if(memo != unions.end()) {
+                    return memo->second;
+                }
+                SmallVector<Value*,8> merged;
+                merged.reserve(sets[a].size() + sets[b].size());
+                std::set_union(sets[a].begin(), sets[a].end(), sets[b].begin(), sets[b].end(), std::back_inserter(merged));
+                CondSetId id = internLocked(merged);
+                unions[std::make_pair(a, b)] = id;
+                return id;
+            }
+            bool isSubset(CondSetId a, CondSetId b) { //Every condition of a is in b
+                if(a == 0 || a == b) {
+                    return true;
+                }
+                if(b == 0) {
+                    return false;
+                }
+                std::lock_guard<std::mutex> guard(lock);
+                auto memo = subsets.find(std::make_pair(a, b));
+                if(memo != subsets.end()) {
+                    return memo->second;
+                }
+                bool result = std::includes(sets[b].begin(), sets[b].end(), sets[a].begin(), sets[a].end());
+                subsets[std::make_pair(a, b)] = result;
+                return result;
+            }
+            ArrayRef<Value*> members(CondSetId id) const { //the array of a set does not move once it is interned
+                std::lock_guard<std::mutex> guard(lock);
+                return sets[id];
+            }
+            size_t size(CondSetId id) const {return members(id).size();}
+        }ownConditions;
+        ConditionSetTable &Conditions; //of this pass, or of the master pass in a summary builder
+        /*
+        Debug locations are interned too : every distinct (file, line, column) is stored once, with its file name
+        interned once in files, and flow edges hold its id. A location is resolved to text only when a report is
+        written. Shared by the summary builders like the condition sets, so every operation takes the lock.
+        */
+        struct DebugLocTable {
+            struct Loc {
+                uint32_t file; //index in files
+                uint32_t line;
+                uint32_t column : 31;
+                uint32_t implicitCode : 1;
+            };
+            std::vector<Loc> locs; //indexed by LocId, locs[0] is no location
+            std::vector<StringRef> files; //the keys of fileIds, which do not move, files[0] is none
+            StringMap<uint32_t> fileIds;
+            DenseMap<std::pair<uint64_t,uint32_t>, LocId> locIds; //keyed by (file << 32 | line, column << 1 | implicitCode)
+            DenseMap<const DILocation*, LocId> nodeIds; //so each location node is resolved once
+            mutable std::mutex lock;
+            DebugLocTable() : locs(1, Loc{0, 0, 0, 0}), files(1) {}
+            LocId intern(const DebugLoc &location) {
+                const DILocation *node = location.get();
+                if(!node) {
+                    return 0;
+                }
+                std::lock_guard<std::mutex> guard(lock);
+                auto memo = nodeIds.find(node);
+                if(memo != nodeIds.end()) {
+                    return memo->second;
+                }
+                auto file = fileIds.insert(std::make_pair(node->getFilename(), (uint32_t)files.size()));
+                if(file.second) {
+                    files.push_back(file.first->getKey());
+                }
+                Loc loc{file.first->second, node->getLine(), node->getColumn(), node->isImplicitCode()};
+                auto key = std::make_pair((uint64_t)loc.file << 32 | loc.line, (uint32_t)loc.column << 1 | loc.implicitCode);
+                auto id = locIds.insert(std::make_pair(key, (LocId)locs.size()));
+                if(id.second) {
+                    locs.push_back(loc);
+                }
+                nodeIds[node] = id.first->second;
+                return id.first->second;
+            }
+            Loc get(LocId id) const {
+                std::lock_guard<std::mutex> guard(lock);
+                return locs[id];
+            }
+            unsigned line(LocId id) const {return get(id).line;}
+            StringRef fileName(LocId id) const {
+                std::lock_guard<std::mutex> guard(lock);
+                return files[locs[id].file];
+            }
+        }ownLocations;
+        DebugLocTable &Locations; //shared as Conditions is
+        /*
+        The graph HOFG of the input program is stored in HeapOFGraph.
+        Builder phase : every vertex gets a dense 32 bit id in insertion order and every flow edge an edge id,
+        a flow edge being identified by its (tail,head) pair. Lookups are hash lookups on the Value* of a vertex.
+        Frozen phase : freeze() lays the flow edges out as compressed sparse row out- and in-adjacency arrays,
+        which the path analysis reads. Any mutation drops the snapshot.
+        Overlay : the graph of a summary builder has the module graph as base. Lookups see the vertices and edges
+        of base, which is only read, and what the builder adds stays in the overlay until merge() replays it.
+        The overlays of merged builders are cleared and handed to the next builders, so their arrays and tables
+        keep the capacity they grew to instead of growing again from empty for every SCC.
+        */
+        struct HOFGraph {
+            std::vector<V> vertices; //indexed by VertexId
+            std::vector<F> flows; //indexed by EdgeId
+            std::vector<VertexId> flowTail; //tail vertex of each flow edge
+            std::vector<VertexId> flowHead; //head vertex of each flow edge
+            std::vector<R> derefs;
+            std::vector<D> derived;
+            DenseMap<Value*, VertexId> vertexIds;
+            DenseMap<std::pair<VertexId,VertexId>, EdgeId> flowIds;
+            //Functions whose handlers asked for a vertex before it existed : they have to be analysed again once it is added.
+            //A miss that is straight away followed by inserting that vertex is only a check before insertion, and is dropped.
+            Function *lookupContext = nullptr;
+            mutable DenseMap<Value*, SmallVector<Function*,2>> missedLookups;
+            mutable Value *lastMiss = nullptr;
+            const HOFGraph *base = nullptr;
+            PassRecord *record = nullptr; //set while a function pass is recorded for the summary cache
+            bool frozen = false;
+            std::vector<EdgeId> outBegin, outEdges; //CSR out-adjacency : edges of v are outEdges[outBegin[v]..outBegin[v+1])
+            std::vector<EdgeId> inBegin, inEdges; //CSR in-adjacency
+            size_t numVertices() const {return vertices.size();}
+            size_t numFlows() const {return flows.size();}
+            VertexId findVertex(Value *name) const { //Id in this graph, not looking into base
+                auto it = vertexIds.find(name);
+                return it == vertexIds.end() ? InvalidId : it->second;
+            }
+            const V *lookupVertex(Value *name) const { //Vertex in the overlay or in base
+                auto it = vertexIds.find(name);
+                if(it != vertexIds.end()) {
+                    return &vertices[it->second];
+                }
+                VertexId inBase = base ? base->findVertex(name) : InvalidId;
+                return inBase == InvalidId ? nullptr : &base->vertices[inBase];
+            }
+            bool knowsFlow(Value *tailName, Value *headName) const { //Edge in the overlay or in base
+                if(base && base->knowsFlow(tailName, headName)) {
+                    return true;
+                }
+                VertexId tail = findVertex(tailName), head = findVertex(headName);
+                return tail != InvalidId && head != InvalidId && findFlow(tail, head) != InvalidId;
+            }
+            void noteVertex(Value *name) const { //For a recorded pass : the answer about a vertex the pass did not add itself
+                if(record && !record->addedVertices.count(name) && record->seenVertices.insert(name).second) {
+                    const V *known = lookupVertex(name);
+                    record->vertexReads.push_back(VertexRead{name, known != nullptr, known ? known->vertexTy : ptr});
+                }
+            }
+            void noteFlow(Value *tailName, Value *headName) const {
+                std::pair<Value*,Value*> key(tailName, headName);
+                if(record && !record->addedFlows.count(key) && record->seenFlows.insert(key).second) {
+                    record->flowReads.push_back(FlowRead{tailName, headName, knowsFlow(tailName, headName)});
+                }
+            }
+            bool knowsVertex(Value *name) const { //As hasVertex, without recording a miss
+                noteVertex(name);
+                return lookupVertex(name) != nullptr;
+            }
+            bool hasVertex(Value *name) const {
+                lastMiss = nullptr;
+                if(knowsVertex(name)) {
+                    return true;
+                }
+                if(lookupContext) {
+                    SmallVector<Function*,2> &missedBy = missedLookups[name];
+                    if(missedBy.empty() || missedBy.back() != lookupContext) {
+                        missedBy.push_back(lookupContext);
+                        lastMiss = name;
+                    }
+                }
+                return false;
+            }
+            V getVertex(Value *name) const {
+                noteVertex(name);
+                const V *known = lookupVertex(name);
+                assert(known && "vertex is not in the HOFG");
+                return *known;
+            }
+            const V &vertex(VertexId id) const {return vertices[id];}
+            VertexId addVertex(const V &vertex) { //Id of the vertex, inserting it if it is new. A vertex of base is copied in as it is there.
+                noteVertex(vertex.name);
+                auto ins = vertexIds.insert(std::make_pair(vertex.name, (VertexId)vertices.size()));
+                if(ins.second) {
+                    VertexId inBase = base ? base->findVertex(vertex.name) : InvalidId;
+                    vertices.push_back(inBase == InvalidId ? vertex : base->vertices[inBase]);
+                    frozen = false;
+                    if(record) {
+                        record->vertices.push_back(vertices.back());
+                        if(inBase == InvalidId) {
+                            record->addedVertices.insert(vertex.name);
+                        }
+                    }
+                    if(lastMiss == vertex.name) {
+                        auto missed = missedLookups.find(vertex.name);
+                        missed->second.pop_back();
+                        if(missed->second.empty()) {
+                            missedLookups.erase(missed);
+                        }
+                    }
+                }
+                lastMiss = nullptr;
+                return ins.first->second;
+            }
+            bool insertVertex(const V &vertex) { //Whether the vertex is new
+                if(base && base->findVertex(vertex.name) != InvalidId) {
+                    noteVertex(vertex.name);
+                    lastMiss = nullptr;
+                    return false;
+                }
+                size_t n = vertices.size();
+                addVertex(vertex);
+                return vertices.size() != n;
+            }
+            EdgeId findFlow(VertexId tail, VertexId head) const {
+                auto it = flowIds.find(std::make_pair(tail, head));
+                return it == flowIds.end() ? InvalidId : it->second;
+            }
+            bool hasFlow(const F &flowEdge) const {
+                noteFlow(flowEdge.tail.name, flowEdge.head.name);
+                return knowsFlow(flowEdge.tail.name, flowEdge.head.name);
+            }
+            bool insertFlow(const F &flowEdge) { //End points of a new edge become vertices if they are not already
+                noteFlow(flowEdge.tail.name, flowEdge.head.name);
+                if(base && base->knowsFlow(flowEdge.tail.name, flowEdge.head.name)) {
+                    return false;
+                }
+                VertexId tail = addVertex(flowEdge.tail);
+                VertexId head = addVertex(flowEdge.head);
+                if(!flowIds.insert(std::make_pair(std::make_pair(tail, head), (EdgeId)flows.size())).second) {
+                    return false;
+                }
+                flows.push_back(flowEdge);
+                flowTail.push_back(tail);
+                flowHead.push_back(head);
+                frozen = false;
+                if(record) {
+                    record->flows.push_back(flowEdge);
+                    record->addedFlows.insert(std::make_pair(flowEdge.tail.name, flowEdge.head.name));
+                }
+                return true;
+            }
+            void merge(const HOFGraph &overlay) { //Add what a builder overlay added, in the order it did, with its missed lookups
+                for(const V &vertex : overlay.vertices) {
+                    addVertex(vertex);
+                }
+                for(const F &flowEdge : overlay.flows) {
+                    insertFlow(flowEdge);
+                }
+                for(auto &missed : overlay.missedLookups) {
+                    SmallVector<Function*,2> &missedBy = missedLookups[missed.first];
+                    for(Function *F : missed.second) {
+                        if(std::find(missedBy.begin(), missedBy.end(), F) == missedBy.end()) {
+                            missedBy.push_back(F);
+                        }
+                    }
+                }
+            }
+            void eraseFlows(const BitVector &dead) { //Drop the flow edges marked in dead, keeping the order of the rest
+                EdgeId next = 0;
+                flowIds.clear();
+                for(EdgeId e = 0; e < flows.size(); e++) {
+                    if(dead.test(e)) {
+                        continue;
+                    }
+                    if(next != e) {
+                        flows[next] = std::move(flows[e]);
+                        flowTail[next] = flowTail[e];
+                        flowHead[next] = flowHead[e];
+                    }
+                    flowIds[std::make_pair(flowTail[next], flowHead[next])] = next;
+                    next++;
+                }
+                flows.resize(next);
+                flowTail.resize(next);
+                flowHead.resize(next);
+                frozen = false;
+            }
+            void freeze() { //Build the CSR snapshot by counting sort on the edge end points
+                if(frozen) {
+                    return;
+                }
+                size_t n = vertices.size();
+                outBegin.assign(n + 1, 0);
+                inBegin.assign(n + 1, 0);
+                for(EdgeId e = 0; e < flows.size(); e++) {
+                    outBegin[flowTail[e] + 1]++;
+                    inBegin[flowHead[e] + 1]++;
+                }
+                for(size_t v = 0; v < n; v++) {
+                    outBegin[v + 1] += outBegin[v];
+                    inBegin[v + 1] += inBegin[v];
+                }
+                outEdges.resize(flows.size());
+                inEdges.resize(flows.size());
+                std::vector<EdgeId> outPos(outBegin.begin(), outBegin.end() - 1);
+                std::vector<EdgeId> inPos(inBegin.begin(), inBegin.end() - 1);
+                for(EdgeId e = 0; e < flows.size(); e++) {
+                    outEdges[outPos[flowTail[e]]++] = e;
+                    inEdges[inPos[flowHead[e]]++] = e;
+                }
+                frozen = true;
+            }
+            ArrayRef<EdgeId> outFlows(VertexId v) const {
+                assert(frozen && "HOFG is not frozen");
+                return makeArrayRef(outEdges.data() + outBegin[v], outEdges.data() + outBegin[v + 1]);
+            }
+            ArrayRef<EdgeId> outFlows(const V &vertex) const { //Successor edges of a vertex, empty if it is not in the graph
+                VertexId v = findVertex(vertex.name);
+                return v == InvalidId ? ArrayRef<EdgeId>() : outFlows(v);
+            }
+            ArrayRef<EdgeId> inFlows(VertexId v) const {
+                assert(frozen && "HOFG is not frozen");
+                return makeArrayRef(inEdges.data() + inBegin[v], inEdges.data() + inBegin[v + 1]);
+            }
+            void clear() { //Empty, and without a base, keeping the capacity of the arrays and the tables
+                vertices.clear();
+                flows.clear();
+                flowTail.clear();
+                flowHead.clear();
+                derefs.clear();
+                derived.clear();
+                vertexIds.clear();
+                flowIds.clear();
+                lookupContext = nullptr;
+                missedLookups.clear();
+                lastMiss = nullptr;
+                base = nullptr;
+                record = nullptr;
+                frozen = false;
+                outBegin.clear();
+                outEdges.clear();
+                inBegin.clear();
+                inEdges.clear();
+            }
+        }HeapOFGraph;
+        enum argTransformBit {allocatesArg = 1, deallocatesArg = 2};
+        struct FuncSummary { //Datastructure for storing function summary
+            Function *funcName; //pointer to the function
+            funcType functionType = noop; //Indicate the nature of the function - allocator,deallocator,allocdealloc
+            SmallVector<uint8_t,4> argTransforms; //Transformation of each argument, by argument number : argTransformBit mask
+            SmallVector<Value*,2> globalAlloc;//Variables that have scope outside the function that are being allocated
+            SmallVector<Value*,2> globalDealloc;//Variables that have scope outside the function that are being deallocted
+            SmallVector<Value*,2> returnValues;
+            bool generated = false; //generateFunctionSummary has run on the function
+            explicit FuncSummary(Function *F) : funcName(F), argTransforms(F->arg_size(), 0) {}
+            void addArgTransform(unsigned argNo, funcType t) {
+                argTransforms[argNo] |= (t == allocator ? allocatesArg : deallocatesArg);
+            }
+            uint8_t allTransforms() const { //argTransformBits of any argument
+                uint8_t all = 0;
+                for(uint8_t t : argTransforms) {
+                    all |= t;
+                }
+                return all;
+            }
+            static bool addValue(SmallVectorImpl<Value*> &values, Value *value) { //The value sets are kept sorted
+                auto pos = std::lower_bound(values.begin(), values.end(), value);
+                if(pos != values.end() && *pos == value) {
+                    return false;
+                }
+                values.insert(pos, value);
+                return true;
+            }
         };
-        mutable std::set<HOFGpath> pathSet;
-        mutable std::list<HOFGpath> pathList;
-        std::set<HOFGpath>::iterator psit;
-        std::set<FuncSummary> allFuncSummaries; //set of all function summaries
-        std::set<FuncSummary>::iterator fsit;
-        std::set<V>::iterator vit;
-        std::list<funcType>::iterator argTransformIt;
-        std::set<predBB> allBBs; //set of all basic blocks and their predecessors
-        struct E { //Set of all  edges : for the time being, not used.
-            std::set<F> flows;
-            std::set<R> derefs;
-            std::set<D> derived;
+        /*
+        Function summaries by function : a hash lookup on the Function*. Summaries are added in the order of
+        summariseCallGraph before any builder runs and do not move afterwards, so handlers keep pointers to them.
+        They are cut from a bump allocator and destroyed together with the table.
+        */
+        struct SummaryTable {
+            SpecificBumpPtrAllocator<FuncSummary> storage;
+            DenseMap<const Function*, FuncSummary*> index;
+            std::vector<FuncSummary*> summaries; //in insertion order
+            FuncSummary *find(const Function *F) {
+                return index.lookup(F);
+            }
+            FuncSummary &insert(Function *F) {
+                auto ins = index.insert(std::make_pair(F, nullptr));
+                if(ins.second) {
+                    ins.first->second = new (storage.Allocate()) FuncSummary(F);
+                    summaries.push_back(ins.first->second);
+                }
+                return *ins.first->second;
+            }
+            pointee_iterator<std::vector<FuncSummary*>::iterator> begin() {return summaries.begin();}
+            pointee_iterator<std::vector<FuncSummary*>::iterator> end() {return summaries.end();}
         };
-	    bool runOnModule(Module &M) override {//Module pass
-            errs()<<"Entered module pass";
-            
-            HOFGraph P;
-            int count = 0;
-            do { // loop until no change in HOFG
-                errs()<<"\n ///////////////////////////////////////////////////////////// \n";
-                P=HeapOFGraph;
-                generateSummary(M);
-                count++;
-            } while ((!(HeapOFGraph == P)));
-            //P=HeapOFGraph;
-            //constructHOFG(M);
-            
-            /*
-            Function : printHOFG
-            Output : Prints the generated HOFG : edges and vertices
-            */
-            printHOFG();
-            generatePathsFromHOFG();
-            /*printPaths();
-            printPathsList();   
-            pruneLeakLessPaths();
-            detectEndsOFPath();
-            getMayLeakPaths();*/
-            return true;
-	    };
-        void printHOFG() { //To print generated HOFG
-            errs()<<"\nNumber of veritces : "<<HeapOFGraph.vertices.size()<<" \n";
-            int allocationSites = 0;
-            for (V vertex : HeapOFGraph.vertices) {
-                if(vertex.vertexTy == obj) {
-                    allocationSites++;
-                }
-            }
-            errs()<<"\nNumber of edges : "<<HeapOFGraph.flows.size()<<" \n";
-            std::set<F>::iterator f=HeapOFGraph.flows.begin();
-            int e = HeapOFGraph.flows.size();
-            int ce = e;
-            while(e>1) {//To erase copy of edges
-                int count = 0;
-                ce=HeapOFGraph.flows.size();
-                std::set<F>::iterator c=f;
-                while(ce>2) {
-                    if((*f)==(*c)) {
-                        count++;
-                        if(count > 1) {
-                            //errs()<<"\nDeleting because of copy";
-                            //(*c).tail.name->dump();
-                            //errs()<<"-->";
-                            //(*c).head.name->dump();
-                            HeapOFGraph.flows.erase(c);
-                            ce--;
-                            e--;
-                            break;
+        SummaryTable ownFuncSummaries;
+        SummaryTable &allFuncSummaries; //all function summaries, shared with the summary builders
+        FuncSummary *summaryOf(const Function *F) {return allFuncSummaries.find(F);}
+        /*
+        Guarding conditions of a block : the conditions of the branches it is control dependent on, transitively.
+        Block B is control dependent on the conditional branch ending P when B post-dominates a successor of P
+        but not P, so walking the post-dominator tree up from each successor of P to the immediate post-dominator
+        of P finds those blocks. The closure over the branch blocks is a fixpoint in reverse post order.
+        Computed once per function, as condition set ids, and shared by the summary builders.
+        */
+        typedef DenseMap<const BasicBlock*, CondSetId> BlockGuards;
+        struct GuardCache {
+            DenseMap<const Function*, std::unique_ptr<BlockGuards>> functions;
+            std::mutex lock;
+        }ownGuards;
+        GuardCache &Guards;
+        const Function *guardsFunction = nullptr; //function of guards
+        const BlockGuards *guards = nullptr;
+        const BlockGuards &guardingConditions(Function &F) {
+            {
+                std::lock_guard<std::mutex> guard(Guards.lock);
+                auto it = Guards.functions.find(&F);
+                if(it != Guards.functions.end()) {
+                    return *it->second;
+                }
+            }
+            std::unique_ptr<BlockGuards> computed = computeGuards(F);
+            std::lock_guard<std::mutex> guard(Guards.lock);
+            return *Guards.functions.insert(std::make_pair(&F, std::move(computed))).first->second;
+        }
+        std::unique_ptr<BlockGuards> computeGuards(Function &F) {
+            std::unique_ptr<BlockGuards> blockGuards(new BlockGuards());
+            PostDominatorTree PDT(F);
+            DenseMap<const BasicBlock*, SmallVector<BasicBlock*,2>> controllers; //branch blocks a block is control dependent on
+            for(BasicBlock &P : F) {
+                BranchInst *br = dyn_cast_or_null<BranchInst>(P.getTerminator());
+                if(!br || !br->isConditional()) {
+                    continue;
+                }
+                DomTreeNode *stop = PDT.getNode(&P) ? PDT.getNode(&P)->getIDom() : nullptr;
+                for(BasicBlock *S : br->successors()) {
+                    for(DomTreeNode *runner = PDT.getNode(S); runner && runner != stop && runner->getBlock(); runner = runner->getIDom()) {
+                        SmallVector<BasicBlock*,2> &list = controllers[runner->getBlock()];
+                        if(list.empty() || list.back() != &P) {
+                            list.push_back(&P);
                         }
                     }
-                    c++;
-                    ce--;
                 }
-                f++;
-                e--;
             }
-            
-            std::set<F>::iterator fitr=HeapOFGraph.flows.begin();
-            int edgesize = HeapOFGraph.flows.size();
-            int cesize = edgesize;
-            while(edgesize>1) {//To erase back edges
-                int count = 0;
-                cesize=HeapOFGraph.flows.size();
-                std::set<F>::iterator citr=fitr;
-                while(cesize>2) {
-                    if(((*fitr).head==(*citr).tail) && ((*fitr).tail==(*citr).head)) {
-                        count++;
-                        if(count > 0) {
-                            HeapOFGraph.flows.erase(citr);
-                            cesize--;
-                            edgesize--;
-                            break;
-                        }
+            if(controllers.empty()) {
+                return blockGuards;
+            }
+            ReversePostOrderTraversal<Function*> RPOT(&F);
+            bool changed = true;
+            while(changed) {
+                changed = false;
+                for(BasicBlock *B : RPOT) {
+                    auto it = controllers.find(B);
+                    if(it == controllers.end()) {
+                        continue;
+                    }
+                    CondSetId blockGuard = blockGuards->lookup(B);
+                    for(BasicBlock *P : it->second) {
+                        Value *cond = cast<BranchInst>(P->getTerminator())->getCondition();
+                        blockGuard = Conditions.unite(blockGuard, Conditions.unite(Conditions.single(cond), blockGuards->lookup(P)));
+                    }
+                    if(blockGuard != blockGuards->lookup(B)) {
+                        (*blockGuards)[B] = blockGuard;
+                        changed = true;
                     }
-                    citr++;
-                    cesize--;
                 }
-                fitr++;
-                edgesize--;
+            }
+            return blockGuards;
+        }
+        CondSetId guardOf(BasicBlock *B) {
+            if(B->getParent() != guardsFunction) {
+                guards = &guardingConditions(*B->getParent());
+                guardsFunction = B->getParent();
+            }
+            return guards->lookup(B);
+        }
+	    bool runOnModule(Module &M) override {//Module pass
+            bool analysed = analyseModule(M, true);
+            printAnalysisLog(errs());
+            if(!analysed) {
+                return false;
+            }
+            printHOFG(outs());
+            printLeakReports(errs(), outs());
+            writeStats(M);
+            return true;
+	    };
+        /*
+        Function : analyseModule(M)
+        Builds the HOFG of M from the function summaries, or loads a saved one with -hofg-load-graph, and the leak
+        verdicts on it. Progress and errors go to the analysis log and nothing is printed, so the legacy pass and
+        HOFGAnalysis share it. The legacy pass also marks the summarised functions with metadata, which an
+        analysis may not.
+        Output : false if the saved graph or the allocator file cannot be read, the log says which
+        */
+        bool analyseModule(Module &M, bool markSummaries) {
+            log<<"Entered module pass";
+            moduleBudget.reset();
+            if(!HOFGStatsFile.empty()) {
+                stats.reset(new HOFGStats());
+            }
+            if(!HOFGLoadGraph.empty()) { //Only the leak analysis, on a saved graph
+                std::string error;
+                if(!loadLeakGraph(HOFGLoadGraph, error)) {
+                    log<<"\nCannot load the HOFG from "<<HOFGLoadGraph<<" : "<<error<<"\n";
+                    return false;
+                }
+                log<<"\nLoaded HOFG : "<<leakGraph.numVertices()<<" vertices, "<<leakGraph.numFlows()<<" edges, "
+                    <<leakGraph.summaries.size()<<" function summaries\n";
+                analyseLeaksFromHOFG();
+                return true;
             }
             
-            std::set<F>::iterator A=HeapOFGraph.flows.begin();
-            int C = HeapOFGraph.flows.size();
-            int D = C;
-            while(C>0) {
-                int count = 0;
-                D=HeapOFGraph.flows.size();
-                std::set<F>::iterator B=HeapOFGraph.flows.begin();
-                while(D>0) {
-                    if((*A).tail==(*B).head) {
-                        count++;
-                    }
-                    B++;
-                    D--;
-                }
-                if(count == 0 && (*A).tail.vertexTy != obj) {
-                    std::set<F>::iterator eraseEdge = A;
-                    A++;
-                    HeapOFGraph.flows.erase(eraseEdge);
-                    C--;
-                } else {
-                    A++;
+            std::string error;
+            if(!buildCalleeTable(M, error)) {
+                log<<"\nCannot read the allocators from "<<HOFGAllocatorFile<<" : "<<error<<"\n";
+                return false;
+            }
+            int count;
+            {
+                HOFGStats::Phase phase(stats.get(), HOFGStats::summaryPhase);
+                traverseCallGraph(M);
+                count = summariseCallGraph(); // loop until no change in HOFG
+            }
+            NumSummaryPasses += count;
+            if(markSummaries) {
+                markSummarisedFunctions();
+            }
+            log<<"\n ///////////////////////////////////////////////////////////// \n";
+            log<<"\n"<<count<<" function passes over "<<callGraphSCCs.size()<<" call graph SCCs\n";
+            if(!HOFGCacheDir.empty()) {
+                log<<"\nSummary cache : "<<summaryCacheHits<<" hits, "<<summaryCacheMisses<<" misses\n";
+            }
+            //constructHOFG(M);
+            {
+                HOFGStats::Phase phase(stats.get(), HOFGStats::canonicalPhase);
+                canonicalizeHOFG();
+            }
+            buildLeakGraph();
+            if(!HOFGSaveGraph.empty() && !saveLeakGraph(HOFGSaveGraph)) {
+                log<<"\nCannot write the HOFG to "<<HOFGSaveGraph<<"\n";
+            }
+            analyseLeaksFromHOFG();
+            return true;
+        }
+        std::unique_ptr<HOFGStats> stats; //of the analysis, with -hofg-stats
+        std::string analysisLog; //progress and errors of analyseModule, which the passes print
+        raw_string_ostream log{analysisLog};
+        void printAnalysisLog(raw_ostream &os) { //Once per analyseModule
+            os<<log.str();
+            analysisLog.clear();
+        }
+        void writeStats(Module &M) { //With -hofg-stats, after the leak reports are printed
+            if(stats && !stats->write(HOFGStatsFile, M.getModuleIdentifier())) {
+                errs()<<"\nCannot write the statistics to "<<HOFGStatsFile<<"\n";
+            }
+        }
+        /*
+        Function : canonicalizeHOFG
+        The one stage that rewrites the generated HOFG before it is printed and analysed. Flow edges are already
+        unique on (tail,head), so what is left is, in this order over the edges :
+            back edges : of a pair of opposite edges the later one is erased,
+            dead tails : an edge whose tail is not an obj node and is not reached by any remaining edge is erased,
+            which can leave the head of the edge unreached for the later edges,
+            self loops and edges into obj nodes are erased.
+        Each rule is one walk over the edges with hash lookups on the pair index, and all of them mark one mask,
+        so the edge arrays and the pair index are compacted once. Linear in the number of edges.
+        */
+        void canonicalizeHOFG() {
+            log<<"\nNumber of veritces : "<<HeapOFGraph.vertices.size()<<" \n";
+            log<<"\nNumber of edges : "<<HeapOFGraph.flows.size()<<" \n";
+            size_t numFlows = HeapOFGraph.numFlows();
+            BitVector dead(numFlows);
+            for(EdgeId e = 0; e < numFlows; e++) {//To erase back edges
+                if(dead.test(e)) {
+                    continue;
+                }
+                EdgeId back = HeapOFGraph.findFlow(HeapOFGraph.flowHead[e], HeapOFGraph.flowTail[e]);
+                if(back != InvalidId && back > e) {
+                    dead.set(back);
                 }
-                C--;
             }
-            std::set<F>::iterator sl=HeapOFGraph.flows.begin();
-            std::set<F>::iterator nsl;
-            int sll = HeapOFGraph.flows.size();
-            while(sll > 0) {
-                if((*sl).head.name == (*sl).tail.name || (*sl).head.vertexTy == obj) {
-                    if((*sl).head.vertexTy == obj) {
-                    errs()<<"\nhead is obj";
-                    }
-
-                    nsl=sl;
-                    sl++;
-                    HeapOFGraph.flows.erase(nsl);
-                    sll --;
+            BitVector backEdge = dead;
+            std::vector<unsigned> inDegree(HeapOFGraph.numVertices());
+            for(EdgeId e = 0; e < numFlows; e++) {
+                if(!backEdge.test(e)) {
+                    inDegree[HeapOFGraph.flowHead[e]]++;
+                }
+            }
+            for(EdgeId e = 0; e < numFlows; e++) {//To erase edges whose tail is not reached by any edge
+                VertexId tail = HeapOFGraph.flowTail[e];
+                if(!backEdge.test(e) && inDegree[tail] == 0 && HeapOFGraph.flows[e].tail.vertexTy != obj) {
+                    dead.set(e);
+                    inDegree[HeapOFGraph.flowHead[e]]--;
+                }
+            }
+            for(EdgeId e = 0; e < numFlows; e++) {//To erase self loops and edges into obj nodes
+                const F &flowEdge = HeapOFGraph.flows[e];
+                if(backEdge.test(e)) {
+                    continue;
+                }
+                if(flowEdge.head.name == flowEdge.tail.name || flowEdge.head.vertexTy == obj) {
+                    dead.set(e);
                 }
-                sll--;
             }
+            NumFlowsCanonicalised += dead.count();
+            HeapOFGraph.eraseFlows(dead);
+        }
+        /*
+        Function : printHOFG(os)
+        Output : Prints the canonical HOFG : its edges, streamed in edge order. The graph is not changed.
+        */
+        void printHOFG(raw_ostream &os) const {
             //errs()<<"\nNumber of edges : "<<HeapOFGraph.flows.size()<<" \n";
             //errs()<<"\nPrinting HOFG : "<<HeapOFGraph.flows.size()<< " edges\n";
-            for (F e : HeapOFGraph.flows) {
-                outs()<<*(e.tail.name);
-                outs()<<"-->";
-                outs()<<*(e.head.name);
-                //outs()<<"\nWith conditions :";
+            ValuePrinter printer;
+            for (const F &e : HeapOFGraph.flows) {
+                printer.print(e.tail.name, os);
+                os<<"-->";
+                printer.print(e.head.name, os);
+                //os<<"\nWith conditions :";
                 //for(auto v : e.conditions) {
-                //    outs()<<*(v)<<"\n";
+                //    os<<*(v)<<"\n";
                 //}
-                outs()<<"\n............................................................\n";
+                os<<"\n............................................................\n";
                 if(isa<PHINode>(e.tail.name) || isa<PHINode>(e.head.name)) {
 
                 } else {
@@ -286,1019 +1162,1264 @@ namespace {
             //}
         }
         /*
-        Function : print the paths in the HOFG
-        Input : The pathSet structure instance in the program
-        Output : List of paths generated from the graph is printed
+        Function : print a path in the HOFG
+        Input : The start vertex of the path and its flow edges
+        Output : The path is printed to os
        */
-        void printPaths() {
-            errs()<<"\nNumber of paths::"<<pathList.size()<<"\n";
-        }
-        void printPathsList() {
-            int psize = pathList.size();
-            std::list<HOFGpath>::iterator p=pathList.begin();
-            while(psize>0){
-                outs()<<"\n Starting from : ";
-                //errs()<<*((*p).start.name);
-                outs()<<*((*p).start.name);
-                outs()<<"\nPath edge size: "<<(*p).pathEdge.size()<<"\n";
-                for (F flowEdge : (*p).pathEdge) {
-                    outs()<<"-->";
-                    outs()<<*(flowEdge.head.name);
-                    outs()<<"\n";
-                }
-                outs()<<"\nEnd of path";
-                psize--;
-                p++;
-            }
-        }
-        void printPathsSet() {
-            errs()<<"\nNumber of paths:"<<pathSet.size()<<"\n";
-            int psize = pathSet.size();
-            std::set<HOFGpath>::iterator p=pathSet.begin();
-            //for(HOFGpath p : pathSet) {
-            while(psize>0){
-                outs()<<"\n Starting from : ";
-                //errs()<<*((*p).start.name);
-                outs()<<*((*p).start.name);
-                outs()<<"\nPath edge size: "<<(*p).pathEdge.size()<<"\n";
-                for (F flowEdge : (*p).pathEdge) {
-                    outs()<<"-->";
-                    outs()<<*(flowEdge.head.name);
-                    outs()<<"\n";
-                }
-                outs()<<"\nEnd of path";
-                psize--;
-                p++;
-            }
-        }
-        void detectEndsOFPath() {
-            std::set<V> endVertex;
-            std::set<F> endEdges;
-            for(HOFGpath path : pathList) {
-                for(F flowEdgeInPath : path.pathEdge) {
-                    bool foundLink = false;
-                    for(F f : path.pathEdge) {
-                        if(flowEdgeInPath.head == f.tail) {
-                            foundLink = true;
-                        }
-                    }
-                    //if(!foundLink && flowEdgeInPath.head.vertexTy != snk && )
-                    if(!foundLink && flowEdgeInPath.head.vertexTy != snk) {
-                        endVertex.insert(flowEdgeInPath.head);
-                        endEdges.insert(flowEdgeInPath);
-                    }
-                }
-            }
-            errs()<<"\nEnd points : ::::"<<endEdges.size()<<"\n";
-            for(F endedge : endEdges) {
-                //errs()<<"\n....................................................\n";
-                //endedge.tail.name->dump();
-                //endedge.head.name->dump();
-                //if(isa<PHINode>(endedge.head.name)) {
-                //    errs()<<"\n its here\n";
-                //} else if (isa<PHINode>(endedge.tail.name) && isa<PHINode>(endedge.head.name)) {
-                //    errs()<<"\nboth are phi\n";
-                //} else {
-                    errs()<<"\nIn line ::: "<<endedge.location.getLine()<< "\n";
-                    auto *Scope = cast<DIScope>(endedge.location->getScope());
-                    std::string fileName = Scope->getFilename().str();
-                    errs()<<"in file : "<<fileName<<"\n";
-                //}
+        template <typename EdgeSet> void printPath(const V &start, const EdgeSet &pathEdge, raw_ostream &os, ValuePrinter &printer) {
+            os<<"\n Starting from : ";
+            printer.print(start.name, os);
+            os<<"\nPath edge size: "<<pathEdge.size()<<"\n";
+            for (const F &flowEdge : pathEdge) {
+                os<<"-->";
+                printer.print(flowEdge.head.name, os);
+                os<<"\n";
             }
-            errs()<<"\n";
+            os<<"\nEnd of path";
         }
-        void detectEndsOFPathFromHOFG() {
-            std::set<V> endVertex;
-            std::set<F> endEdges;
-            bool endMark = false;
-            int count = 0;
-            for(F edgeInGraph : HeapOFGraph.flows) {
-                endMark = false;
-                for(F otherEdge : HeapOFGraph.flows) {
-                    if(edgeInGraph.head == otherEdge.tail) {
-                        endMark = true;
-                    }
+        struct locAndFile {
+            int loc;
+            std::string fileName;
+            bool operator < (const locAndFile &other) const {return (loc < other.loc || (loc == other.loc && fileName < other.fileName));}
+            bool operator == (const locAndFile &other) const {return (loc == other.loc && fileName == other.fileName);}
+        };
+        /*
+        The leak analysis reads the pruned HOFG as a LeakGraph : flat records of its vertices and edges, holding
+        what the analysis asks of their values already worked out, the CSR adjacency of the frozen HOFG and a
+        string table of printed values and file names. Vertex and edge ids are those of HeapOFGraph.
+        Built from HeapOFGraph, the arrays are owned by leakGraphStore or are the CSR arrays of HeapOFGraph.
+        Loaded with -hofg-load-graph, they point into the mapping of the file -hofg-save-graph wrote, which is
+        a header followed by the arrays as they are in memory, each at an 8 byte aligned offset.
+        */
+        enum leakVertexFlag {globalVertex = 1, escapeVertex = 2, locatedVertex = 4};
+        struct LeakVertex {
+            uint32_t vertexTy;
+            uint32_t flags;
+            VertexId castOf; //allocation the vertex is a bitcast of : InvalidId if none, ManyOrigins if not in the graph
+            uint32_t text; //printed value, for the obj nodes and the heads of their edges only
+            uint32_t line; //debug location of the instruction when locatedVertex is set
+            uint32_t file;
+        };
+        struct LeakEdge {
+            VertexId tail;
+            VertexId head;
+            uint32_t conditions; //number of branch conditions
+            uint32_t line; //0 if the edge has no debug location
+            uint32_t file;
+        };
+        enum savedRefKind {globalAllocRef, globalDeallocRef, returnValueRef};
+        struct SavedSummary {
+            uint32_t function; //name
+            uint32_t functionType;
+            uint32_t firstTransform, numTransforms; //argTransformBit mask of each argument, in summaryTransforms
+            uint32_t firstRef, numRefs; //in summaryRefs
+        };
+        struct SavedSummaryRef {
+            uint32_t kind; //savedRefKind
+            uint32_t value; //string of the value
+        };
+        struct LeakGraph {
+            ArrayRef<LeakVertex> vertices;
+            ArrayRef<LeakEdge> edges;
+            ArrayRef<EdgeId> outBegin, outEdges, inBegin, inEdges;
+            ArrayRef<uint32_t> stringBegin; //string i is strings[stringBegin[i]..stringBegin[i+1])
+            StringRef strings;
+            ArrayRef<SavedSummary> summaries;
+            ArrayRef<uint32_t> summaryTransforms;
+            ArrayRef<SavedSummaryRef> summaryRefs;
+            size_t numVertices() const {return vertices.size();}
+            size_t numFlows() const {return edges.size();}
+            ArrayRef<EdgeId> outFlows(VertexId v) const {return outEdges.slice(outBegin[v], outBegin[v + 1] - outBegin[v]);}
+            ArrayRef<EdgeId> inFlows(VertexId v) const {return inEdges.slice(inBegin[v], inBegin[v + 1] - inBegin[v]);}
+            StringRef string(uint32_t id) const {return strings.slice(stringBegin[id], stringBegin[id + 1]);}
+        }leakGraph;
+        struct LeakGraphStore {
+            std::vector<LeakVertex> vertices;
+            std::vector<LeakEdge> edges;
+            std::vector<uint32_t> stringBegin;
+            std::string strings;
+            StringMap<uint32_t> stringIds;
+            std::vector<SavedSummary> summaries;
+            std::vector<uint32_t> summaryTransforms;
+            std::vector<SavedSummaryRef> summaryRefs;
+            LeakGraphStore() : stringBegin(1, 0) {
+                addString("");
+            }
+            uint32_t addString(StringRef text) {
+                auto ins = stringIds.insert(std::make_pair(text, (uint32_t)stringIds.size()));
+                if(ins.second) {
+                    strings += text.str();
+                    stringBegin.push_back(strings.size());
                 }
-                if(!endMark) {
-                    if(edgeInGraph.head.vertexTy == snk) {
-
-                    } else {
-                        count++;
-                        endVertex.insert(edgeInGraph.head);
-                        endEdges.insert(edgeInGraph);
-                    }
+                return ins.first->second;
+            }
+        }leakGraphStore;
+        std::unique_ptr<sys::fs::mapped_file_region> savedGraphMapping;
+        uint32_t valueText(Value *value) {
+            std::string text;
+            raw_string_ostream os(text);
+            value->print(os, true);
+            return leakGraphStore.addString(os.str());
+        }
+        uint32_t debugFile(LocId location) {
+            return leakGraphStore.addString(Locations.fileName(location));
+        }
+        /*
+        Function : buildLeakGraph
+        Input : the pruned HeapOFGraph and allFuncSummaries
+        Output : leakGraph over leakGraphStore and the CSR arrays of HeapOFGraph, which is frozen
+        */
+        void buildLeakGraph() {
+            HeapOFGraph.freeze();
+            LeakGraphStore &store = leakGraphStore;
+            size_t n = HeapOFGraph.numVertices();
+            store.vertices.assign(n, LeakVertex());
+            for(VertexId v = 0; v < n; v++) {
+                const V &vertex = HeapOFGraph.vertex(v);
+                LeakVertex &lv = store.vertices[v];
+                lv.vertexTy = vertex.vertexTy;
+                lv.flags = (isa<GlobalVariable>(vertex.name) ? globalVertex : 0) | (isEscapeVertex(vertex.name) ? escapeVertex : 0);
+                lv.castOf = InvalidId;
+                if(Value *origin = allocationOfCast(vertex.name)) {
+                    VertexId o = HeapOFGraph.findVertex(origin);
+                    lv.castOf = (o == InvalidId) ? ManyOrigins : o;
+                }
+                lv.text = lv.line = lv.file = 0;
+                Instruction *ins = dyn_cast<Instruction>(vertex.name);
+                if(LocId at = ins ? Locations.intern(ins->getDebugLoc()) : 0) {
+                    lv.flags |= locatedVertex;
+                    lv.line = Locations.line(at);
+                    lv.file = debugFile(at);
                 }
             }
-            errs()<<"\n "<<count<<" end edges\n";
-            errs()<<"\n "<<endVertex.size()<<" end points\n";
-            for(V ends : endVertex) {
-                ends.name->dump();
+            store.edges.assign(HeapOFGraph.numFlows(), LeakEdge());
+            for(EdgeId e = 0; e < HeapOFGraph.numFlows(); e++) {
+                const F &flowEdge = HeapOFGraph.flows[e];
+                LeakEdge &le = store.edges[e];
+                le.tail = HeapOFGraph.flowTail[e];
+                le.head = HeapOFGraph.flowHead[e];
+                le.conditions = Conditions.size(flowEdge.conditions);
+                le.line = le.file = 0;
+                if(flowEdge.location) {
+                    le.line = Locations.line(flowEdge.location);
+                    le.file = debugFile(flowEdge.location);
+                }
             }
-            for(F endedge : endEdges) {
-                //endedge.tail.name->dump();
-                //errs()<<"\nIn line : "<<endedge.location.getLine()<< "\n";
-                //auto *Scope = cast<DIScope>(endedge.location->getScope());
-                //std::string fileName = Scope->getFilename().str();
-                //errs()<<"in file : "<<fileName<<"\n";
+            for(VertexId v = 0; v < n; v++) { //The values a leak report prints : obj nodes and the heads of their edges
+                if(HeapOFGraph.vertex(v).vertexTy != obj) {
+                    continue;
+                }
+                store.vertices[v].text = valueText(HeapOFGraph.vertex(v).name);
+                for(EdgeId e : HeapOFGraph.outFlows(v)) {
+                    store.vertices[HeapOFGraph.flowHead[e]].text = valueText(HeapOFGraph.vertex(HeapOFGraph.flowHead[e]).name);
+                }
+            }
+            for(const FuncSummary &summary : allFuncSummaries) {
+                SavedSummary saved;
+                saved.function = store.addString(summary.funcName->getName());
+                saved.functionType = summary.functionType;
+                saved.firstTransform = store.summaryTransforms.size();
+                for(uint8_t t : summary.argTransforms) {
+                    store.summaryTransforms.push_back(t);
+                }
+                saved.numTransforms = store.summaryTransforms.size() - saved.firstTransform;
+                saved.firstRef = store.summaryRefs.size();
+                saveSummaryRefs(summary.globalAlloc, globalAllocRef);
+                saveSummaryRefs(summary.globalDealloc, globalDeallocRef);
+                saveSummaryRefs(summary.returnValues, returnValueRef);
+                saved.numRefs = store.summaryRefs.size() - saved.firstRef;
+                store.summaries.push_back(saved);
+            }
+            leakGraph.vertices = store.vertices;
+            leakGraph.edges = store.edges;
+            leakGraph.outBegin = HeapOFGraph.outBegin;
+            leakGraph.outEdges = HeapOFGraph.outEdges;
+            leakGraph.inBegin = HeapOFGraph.inBegin;
+            leakGraph.inEdges = HeapOFGraph.inEdges;
+            leakGraph.stringBegin = store.stringBegin;
+            leakGraph.strings = store.strings;
+            leakGraph.summaries = store.summaries;
+            leakGraph.summaryTransforms = store.summaryTransforms;
+            leakGraph.summaryRefs = store.summaryRefs;
+        }
+        void saveSummaryRefs(ArrayRef<Value*> values, savedRefKind kind) { //Values as summary cache references, printed if they have none
+            for(Value *value : values) {
+                std::string text;
+                raw_string_ostream os(text);
+                if(!writeValueRef(value, os)) {
+                    text.clear();
+                    value->print(os, true);
+                }
+                leakGraphStore.summaryRefs.push_back(SavedSummaryRef{kind, leakGraphStore.addString(os.str())});
+            }
+        }
+        enum savedSection {vertexSection, edgeSection, outBeginSection, outEdgeSection, inBeginSection, inEdgeSection,
+            stringBeginSection, stringSection, summarySection, transformSection, summaryRefSection, numSavedSections};
+        struct SavedGraphHeader {
+            char magic[8]; //"HOFGRAPH"
+            uint32_t version;
+            uint32_t byteOrder; //0x01020304 as the writer stored it
+            uint64_t offset[numSavedSections]; //from the start of the file, 8 byte aligned
+            uint64_t count[numSavedSections]; //elements
+        };
+        static constexpr uint32_t SavedGraphVersion = 2;
+        static size_t sectionElementSize(unsigned section) {
+            switch(section) {
+                case vertexSection: return sizeof(LeakVertex);
+                case edgeSection: return sizeof(LeakEdge);
+                case stringSection: return 1;
+                case summarySection: return sizeof(SavedSummary);
+                case summaryRefSection: return sizeof(SavedSummaryRef);
+                default: return sizeof(uint32_t);
             }
         }
         /*
-        Function : prune off paths from obj to free nodes in the HOFG
-        Input : The pathSet sturct instance in the program
-        Output : List of paths from the graph that can tentatively contain leak.
-        A path : a sequence of pointers to the edges in the HeapOFGraph
+        Function : saveLeakGraph(path)
+        Output : leakGraph written to path, false if the file cannot be written
         */
-        void pruneLeakLessPaths() {
-            std::list<HOFGpath>::iterator p=pathList.begin();
-            std::list<HOFGpath>::iterator pnext=pathList.begin();
-            int n=pathList.size();
-            while(n>1) {
-                //errs()<<"\n"<<n<<"\n";
-                bool status = false;
-                std::set<Value*> combinedConditions;
-                for(F edge : (*p).pathEdge) {
-                    for(Value* c : edge.conditions) {
-                        combinedConditions.insert(c);
-                    }
-                    if(edge.head.vertexTy == snk) {
-                        status = true;
-                    }
-                }
-                if(status && combinedConditions.size() == 0) {
-                    //errs()<<"\nDeleting\n";
-                    pnext=p++;
-                    pathList.erase(p);
-                    n--;
-                    p=pnext;
-                    //errs()<<"\n size : "<<pathSet.size()<<"\n";
-                } else {
-                    p++;
+        bool saveLeakGraph(StringRef path) {
+            ArrayRef<char> sections[numSavedSections] = {
+                toBytes(leakGraph.vertices), toBytes(leakGraph.edges), toBytes(leakGraph.outBegin), toBytes(leakGraph.outEdges),
+                toBytes(leakGraph.inBegin), toBytes(leakGraph.inEdges), toBytes(leakGraph.stringBegin),
+                makeArrayRef(leakGraph.strings.data(), leakGraph.strings.size()), toBytes(leakGraph.summaries),
+                toBytes(leakGraph.summaryTransforms), toBytes(leakGraph.summaryRefs)};
+            SavedGraphHeader header;
+            memcpy(header.magic, "HOFGRAPH", 8);
+            header.version = SavedGraphVersion;
+            header.byteOrder = 0x01020304;
+            uint64_t offset = alignTo(sizeof(header), 8);
+            for(unsigned section = 0; section < numSavedSections; section++) {
+                header.offset[section] = offset;
+                header.count[section] = sections[section].size() / sectionElementSize(section);
+                offset = alignTo(offset + sections[section].size(), 8);
+            }
+            std::error_code EC;
+            raw_fd_ostream file(path, EC, sys::fs::OF_None);
+            if(EC) {
+                return false;
+            }
+            file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            uint64_t written = sizeof(header);
+            for(unsigned section = 0; section < numSavedSections; section++) {
+                file.write_zeros(header.offset[section] - written);
+                file.write(sections[section].data(), sections[section].size());
+                written = header.offset[section] + sections[section].size();
+            }
+            file.close();
+            return !file.has_error();
+        }
+        template <typename T> static ArrayRef<char> toBytes(ArrayRef<T> array) {
+            return makeArrayRef(reinterpret_cast<const char*>(array.data()), array.size() * sizeof(T));
+        }
+        template <typename T> static ArrayRef<T> savedSection(const char *start, const SavedGraphHeader &header, unsigned section) {
+            return makeArrayRef(reinterpret_cast<const T*>(start + header.offset[section]), header.count[section]);
+        }
+        /*
+        Function : loadLeakGraph(path)
+        Output : leakGraph over the read only mapping of a file written by saveLeakGraph, without copying it.
+        The header and the ids in the arrays are checked, so a damaged file is refused rather than read out of bounds.
+        */
+        bool loadLeakGraph(StringRef path, std::string &error) {
+            int fd;
+            uint64_t fileSize;
+            if(sys::fs::openFileForRead(path, fd) || sys::fs::file_size(path, fileSize)) {
+                error = "cannot open the file";
+                return false;
+            }
+            std::error_code EC;
+            if(fileSize >= sizeof(SavedGraphHeader)) {
+                savedGraphMapping.reset(new sys::fs::mapped_file_region(sys::fs::convertFDToNativeFile(fd),
+                    sys::fs::mapped_file_region::readonly, fileSize, 0, EC));
+            }
+            sys::Process::SafelyCloseFileDescriptor(fd);
+            if(!savedGraphMapping || EC) {
+                error = "cannot map the file";
+                return false;
+            }
+            const char *start = savedGraphMapping->const_data();
+            SavedGraphHeader header;
+            memcpy(&header, start, sizeof(header));
+            if(memcmp(header.magic, "HOFGRAPH", 8) != 0 || header.byteOrder != 0x01020304) {
+                error = "not a saved HOFG of this byte order";
+                return false;
+            }
+            if(header.version != SavedGraphVersion) {
+                error = "saved by another version";
+                return false;
+            }
+            for(unsigned section = 0; section < numSavedSections; section++) {
+                uint64_t size = header.count[section] * sectionElementSize(section);
+                if(header.offset[section] % 8 != 0 || header.offset[section] > fileSize || size > fileSize - header.offset[section]) {
+                    error = "truncated";
+                    return false;
                 }
-                
-                n--;
-            }   
-        }
-        void pruneLeaklessPathsFromPathHead() {
-            //errs()<<"\nPath list size before pruning is "<<pathList.size()<<"\n..";
-            std::list<HOFGpath>::iterator p=pathList.begin();
-            std::list<HOFGpath>::iterator pnext=pathList.begin();
-            int n=pathList.size();
-            while(n>1) {
-                //errs()<<"\n"<<n<<"\n";
-                bool status = false;
-                std::set<Value*> combinedConditions;
-                for(F edge : (*p).pathEdge) {
-                    for(Value* c : edge.conditions) {
-                        combinedConditions.insert(c);
-                    }
-                    if(edge.head.vertexTy == snk) {
-                        status = true;
-                    }
-                }
-                if(status && combinedConditions.size() == 0) {
-                    //errs()<<"\n\n\nDeleting\n\n\n";
-                    pnext=p++;
-                    pathList.erase(p);
-                    n--;
-                    p=pnext;
-                    //errs()<<"\n size : "<<pathSet.size()<<"\n";
-                } else {
-                    p++;
+            }
+            leakGraph.vertices = savedSection<LeakVertex>(start, header, vertexSection);
+            leakGraph.edges = savedSection<LeakEdge>(start, header, edgeSection);
+            leakGraph.outBegin = savedSection<EdgeId>(start, header, outBeginSection);
+            leakGraph.outEdges = savedSection<EdgeId>(start, header, outEdgeSection);
+            leakGraph.inBegin = savedSection<EdgeId>(start, header, inBeginSection);
+            leakGraph.inEdges = savedSection<EdgeId>(start, header, inEdgeSection);
+            leakGraph.stringBegin = savedSection<uint32_t>(start, header, stringBeginSection);
+            leakGraph.strings = StringRef(start + header.offset[stringSection], header.count[stringSection]);
+            leakGraph.summaries = savedSection<SavedSummary>(start, header, summarySection);
+            leakGraph.summaryTransforms = savedSection<uint32_t>(start, header, transformSection);
+            leakGraph.summaryRefs = savedSection<SavedSummaryRef>(start, header, summaryRefSection);
+            if(!checkLeakGraph()) {
+                error = "inconsistent";
+                return false;
+            }
+            return true;
+        }
+        bool checkLeakGraph() { //Every id in leakGraph is in range and the CSR arrays are well formed
+            const LeakGraph &G = leakGraph;
+            size_t n = G.numVertices(), m = G.numFlows(), numStrings = G.stringBegin.size() - 1;
+            if(G.stringBegin.empty() || G.outBegin.size() != n + 1 || G.inBegin.size() != n + 1 ||
+                G.outEdges.size() != m || G.inEdges.size() != m || G.stringBegin.back() != G.strings.size()) {
+                return false;
+            }
+            for(size_t i = 0; i < numStrings; i++) {
+                if(G.stringBegin[i] > G.stringBegin[i + 1]) {
+                    return false;
                 }
-                
-                n--;
-            }
-        //    errs()<<"\nPath list size after pruning leakless paths is: "<<pathList.size()<<"\n..";
-        }
-        void getMayLeakPathsFromPathHead() {
-            std::list<HOFGpath> pathListCopy = pathList;
-            std::list<HOFGpath>::iterator p=pathListCopy.begin();
-            std::list<HOFGpath>::iterator pnext=pathListCopy.begin();
-            int n=pathListCopy.size();
-            while(n>1) {
-                bool status = false;
-                for(F edge : (*p).pathEdge) {
-                    if(edge.head.vertexTy == snk && edge.conditions.size()>0) {
-                        (*p).start.name->dump();
-                        edge.head.name->dump();
-                        status=true;
-                        break;
+            }
+            for(ArrayRef<EdgeId> begin : {G.outBegin, G.inBegin}) {
+                if(begin[0] != 0 || begin[n] != m) {
+                    return false;
+                }
+                for(size_t v = 0; v < n; v++) {
+                    if(begin[v] > begin[v + 1]) {
+                        return false;
                     }
                 }
-                if(status) {
-                    pnext=p++;
-                    //(*p).start.name->dump();
-                    //edge.head.name->dump();
-                    pathListCopy.erase(p);
-                    n--;
-                    p=pnext;
-                } else {
-                    p++;
-                    n--;
+            }
+            for(const LeakVertex &lv : G.vertices) {
+                if(lv.vertexTy > snk || lv.text >= numStrings || lv.file >= numStrings ||
+                    (lv.castOf >= n && lv.castOf != InvalidId && lv.castOf != ManyOrigins)) {
+                    return false;
                 }
             }
-            if(n==1) {
-                bool status = false;
-                for(F edge : (*p).pathEdge) {
-                    if(edge.head.vertexTy == snk && edge.conditions.size()>0) {
-                        status=true;
-                        break;
+            for(const LeakEdge &le : G.edges) {
+                if(le.tail >= n || le.head >= n || le.file >= numStrings) {
+                    return false;
+                }
+            }
+            for(ArrayRef<EdgeId> edges : {G.outEdges, G.inEdges}) {
+                for(EdgeId e : edges) {
+                    if(e >= m) {
+                        return false;
                     }
                 }
-                if(status) {
-                    pathListCopy.erase(p);
+            }
+            for(const SavedSummary &saved : G.summaries) {
+                if(saved.function >= numStrings || saved.firstTransform > G.summaryTransforms.size() ||
+                    saved.numTransforms > G.summaryTransforms.size() - saved.firstTransform ||
+                    saved.firstRef > G.summaryRefs.size() || saved.numRefs > G.summaryRefs.size() - saved.firstRef) {
+                    return false;
                 }
             }
-            //errs()<<"\nNumber of may leak paths : "<<pathList.size() - pathListCopy.size();
+            for(const SavedSummaryRef &ref : G.summaryRefs) {
+                if(ref.kind > returnValueRef || ref.value >= numStrings) {
+                    return false;
+                }
+            }
+            return true;
         }
-        struct locAndFile {
-            int loc;
-            std::string fileName;
-            bool operator < (const locAndFile &other) const {return ((loc < other.loc || fileName != other.fileName));}
-            bool operator == (const locAndFile &other) const {return (loc == other.loc && fileName == other.fileName);}
+        bool locationOf(uint32_t line, uint32_t file, locAndFile &lf) { //A location in leakGraph, false if it has no line
+            lf.loc = line;
+            lf.fileName = leakGraph.string(file).str();
+            return lf.loc > 0;
+        }
+        /*
+        Leak verdicts from reachability on the frozen HOFG, in place of listing the paths of every obj node.
+        Facts of a vertex say what some route out of it reaches; each is seeded on the vertices (or edge tails)
+        where it holds and propagated backwards over the in-adjacency once for the whole graph.
+        An obj node is then classified from its own facts. Only a reported obj node gets a forward walk, restricted
+        to the vertices leading to what is reported, to collect the end locations.
+        */
+        enum leakFact {reachesSink = 1, reachesOpenEnd = 2, reachesGlobalEnd = 4, reachesEscape = 8,
+            reachesGuardedSink = 16, reachesConditionalFree = 32};
+        //in increasing order of severity, then inconclusive : a budget ran out before the verdict
+        enum leakVerdict {freed, escapes, mayLeak, leaks, unused, inconclusive};
+        /*
+        Budgets of the leak analysis, set by the -hofg-source-* and module options, zero for no limit. An obj node
+        spends its own (edges visited, paths enumerated for its witness paths, time) and the module's (edges visited
+        from all the obj nodes, the deadline of the whole analysis, peak memory). The first one to run out makes the
+        verdict inconclusive. A module budget that runs out stays out, so the obj nodes after it are inconclusive
+        without a walk, and a deadline gives the verdicts reached so far instead of a run that does not end.
+        */
+        enum budgetKind {noBudget, sourceEdgeBudget, sourcePathBudget, sourceTimeBudget, moduleEdgeBudget, deadlineBudget,
+            memoryBudget};
+        static const char *budgetName(budgetKind kind) {
+            static const char *const names[] = {"no", "source edge", "source path", "source time", "module edge",
+                "deadline", "memory"};
+            return names[kind];
+        }
+        struct ModuleBudget {
+            std::chrono::steady_clock::time_point start;
+            std::atomic<uint64_t> edgesVisited{0};
+            std::atomic<int> exhausted{noBudget}; //budgetKind of the module budget that ran out
+            void reset() {
+                start = std::chrono::steady_clock::now();
+                edgesVisited = 0;
+                exhausted = noBudget;
+            }
+            bool deadlinePassed() const {
+                return HOFGDeadline && std::chrono::steady_clock::now() - start > std::chrono::seconds(HOFGDeadline);
+            }
+        } moduleBudget;
+        class SourceBudget { //What one obj node has spent. The shared counter and the clock are read every 256 edges
+            ModuleBudget &module;
+            std::chrono::steady_clock::time_point start;
+            uint64_t edges = 0, flushed = 0;
+            bool exhaust(budgetKind kind) {
+                exhausted = kind;
+                return false;
+            }
+            bool exhaustModule(budgetKind kind) {
+                int none = noBudget;
+                module.exhausted.compare_exchange_strong(none, kind);
+                return exhaust(kind);
+            }
+        public:
+            budgetKind exhausted = noBudget;
+            explicit SourceBudget(ModuleBudget &module) : module(module), start(std::chrono::steady_clock::now()) {}
+            ~SourceBudget() {
+                module.edgesVisited += edges - flushed;
+            }
+            bool spendEdge() { //false once a budget has run out
+                if(exhausted != noBudget) {
+                    return false;
+                }
+                edges++;
+                if(HOFGSourceEdges && edges > HOFGSourceEdges) {
+                    return exhaust(sourceEdgeBudget);
+                }
+                return edges % 256 != 0 || check();
+            }
+            bool allowPaths(size_t paths) { //whether one more path may be enumerated next to paths
+                if(exhausted != noBudget) {
+                    return false;
+                }
+                return !HOFGSourcePaths || paths < HOFGSourcePaths || exhaust(sourcePathBudget);
+            }
+            bool check() {
+                if(exhausted != noBudget) {
+                    return false;
+                }
+                if(module.exhausted != noBudget) {
+                    return exhaust((budgetKind)module.exhausted.load());
+                }
+                uint64_t total = module.edgesVisited += edges - flushed;
+                flushed = edges;
+                if(HOFGEdgeBudget && total > HOFGEdgeBudget) {
+                    return exhaustModule(moduleEdgeBudget);
+                }
+                std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+                if(HOFGSourceTime && now - start > std::chrono::milliseconds(HOFGSourceTime)) {
+                    return exhaust(sourceTimeBudget);
+                }
+                if(HOFGDeadline && now - module.start > std::chrono::seconds(HOFGDeadline)) {
+                    return exhaustModule(deadlineBudget);
+                }
+                if(HOFGMemoryBudget && HOFGStats::peakRSSBytes() > ((uint64_t)HOFGMemoryBudget << 20)) {
+                    return exhaustModule(memoryBudget);
+                }
+                return true;
+            }
         };
-        void detectEndsOfPathFromPathHead() {
-            std::set<V> endVertex;
-            std::set<F> endEdges;
+        struct SourceVerdict {
+            VertexId source;
+            leakVerdict verdict;
+            budgetKind budget = noBudget; //that ran out, for an inconclusive verdict
+            EdgeId startEdge = InvalidId; //edge out of the obj node whose allocation is reported
+            unsigned endEdges = 0; //edges into an open end
             std::set<locAndFile> endLocations;
             std::set<locAndFile> mayLeakEnds;
-            F startEdge;
-            bool escaped = false;
-            for(HOFGpath path : pathList) {
-                for(F flowEdgeInPath : path.pathEdge) {
-                    if(Instruction *ins = dyn_cast<Instruction>(flowEdgeInPath.head.name)) {
-                        Function *F = ins->getFunction();
-                        for(Function::iterator FI=F->begin(); FI!=F->end(); FI++) {
-                            BasicBlock &B(*FI);
-                            for(BasicBlock::iterator BI=B.begin(); BI!=B.end(); BI++) {
-                                Instruction &I(*BI);
-                                if(isa<ReturnInst>(I) && I.getNumOperands() > 0) {
-                                    if(I.getOperand(0) == ins || I.getOperand(0) == path.start.name) {
-                                        escaped = true;
-                                    }
-                                    if(I.getOperand(0) == flowEdgeInPath.head.name) {
-                                        escaped = true;
-                                    }
-                                }
-                                if(isFreeFunction(I) && I.getOperand(0) == path.start.name && flowEdgeInPath.conditions.size() > 0) {
-                                    if(!flowEdgeInPath.location.isImplicitCode()) {
-                                        locAndFile lf;
-                                        lf.loc = flowEdgeInPath.location.getLine();
-                                        auto *Scop = cast<DIScope>(flowEdgeInPath.location->getScope());
-                                        lf.fileName = Scop->getFilename().str();
-                                        if(lf.loc > 0 ) {
-                                            mayLeakEnds.insert(lf);
-                                        }
-                                    }
-                                    escaped = true;
-                                }
-                            }
-                        }
-                    }
-                    if(isa<BitCastInst>(flowEdgeInPath.head.name)) {
-                        BitCastInst *btc=dyn_cast<BitCastInst>(flowEdgeInPath.head.name);
-                        if(isa<GlobalVariable>(btc->getOperand(0))) {
-                            escaped=true;
-                        }
-                    }
-                    if(isa<BitCastInst>(flowEdgeInPath.head.name)) {
-                        BitCastInst *btc=dyn_cast<BitCastInst>(flowEdgeInPath.head.name);
-                        if(Instruction *Ins=dyn_cast<Instruction>(btc->getOperand(0))) {
-                            if(isMallocFunction(*Ins)) {
-                                if(path.start.name != dyn_cast<Value>(Ins)) {
-                                    escaped = true;
-                                }
-                            } else if(Instruction *MInst = dyn_cast<Instruction>(Ins->getOperand(0))) {
-                                if(isMallocFunction(*MInst)) {
-                                    if(path.start.name != dyn_cast<Value>(MInst)) {
-                                        escaped = true;
-                                    }
-                                } else if (Instruction *MNInst = dyn_cast<Instruction>(MInst->getOperand(0))) {
-                                    if(isMallocFunction(*MNInst)) {
-                                        if(path.start.name != dyn_cast<Value>(MNInst)) {
-                                            escaped = true;
-                                        }
-                                    }
-                                }
-                            }
-                        }
-                    }
-                    if(isa<Argument>(flowEdgeInPath.head.name) ||
-                    isa<ReturnInst>(flowEdgeInPath.head.name) ||
-                    isa<GlobalVariable>(flowEdgeInPath.head.name)) {
-                        escaped = true;
-                        //flowEdgeInPath.head.name->dump();
-                        //errs()<<"\nEscaped";
-                    }
+        };
+        static constexpr VertexId ManyOrigins = InvalidId - 1;
+        std::vector<uint8_t> leakFacts; //per vertex
+        std::vector<VertexId> castOrigin; //per vertex : allocation reached through a bitcast, InvalidId or ManyOrigins
+        std::vector<uint64_t> pathsToFree, pathsToOpenEnd; //per vertex : paths to a snk node, to an open end
+        std::vector<uint32_t> sccOfVertex; //condensation of leakGraph, SCCs successors first
+        std::vector<uint32_t> sccBegin;
+        std::vector<VertexId> sccMembers;
+        std::vector<SourceVerdict> leakVerdicts; //in vertex order of the obj nodes
+        /*
+        PathEnumerator : the paths from one obj node, yielded one at a time by next() in the order the recursive
+        addEdgeToList used to list them all. The current path is an explicit stack of (vertex, out-edge cursor)
+        frames, one per vertex on it, with the edge that entered the vertex; a later out-edge of a frame branches a
+        new path from the frames below it. Vertices on the path are marked, so the cycle check is one lookup.
+        The stack and the marks are sized once per graph, so a step allocates nothing, and the edges of the path
+        are copied out only when pathEdges() is asked for them. A path ends at a vertex without out-edges, before
+        an edge back into the path, where the budget runs out, or at the first snk node it reaches with no
+        conditional edge : that prefix is leakless whatever follows it, so its extensions are pruned with it.
+        */
+        class PathEnumerator {
+            struct Frame {
+                VertexId vertex;
+                uint32_t next; //index of the next out-edge of vertex
+                EdgeId in; //edge from the vertex of the frame below, InvalidId for the source
+                bool unconditional; //no edge of the path up to the vertex is conditional
+                bool freed; //the path up to the vertex reaches a snk node
+            };
+            const HOFGraph *graph = nullptr;
+            SourceBudget *budget = nullptr;
+            long unsigned int *maxPathEdges = nullptr;
+            std::vector<Frame> stack;
+            std::vector<uint8_t> onPath; //per vertex, set for the heads of the edges on the path
+            size_t created = 0; //paths started, including the current one
+            bool bareSource = false; //the source has no out-edge, its only path is empty
+            bool extend(EdgeId e) { //As addEdgeToList did : false if e ends the current path instead
+                if(*maxPathEdges < stack.size() - 1) {
+                    *maxPathEdges = stack.size() - 1;
                 }
+                VertexId head = graph->flowHead[e];
+                bool circPath = onPath[head] || (stack.size() > 1 && head == stack[0].vertex); //the source is on the path once it has an edge
+                if(!(budget->allowPaths(created) && budget->spendEdge()) || circPath) {
+                    return false;
+                }
+                onPath[head] = 1;
+                const Frame &below = stack.back();
+                const F &edge = graph->flows[e];
+                stack.push_back(Frame{head, 0, e, below.unconditional && edge.conditions == 0, below.freed || edge.head.vertexTy == snk});
+                if(leakless()) { //the prefix is freed on every run, so is any path through it
+                    stack.back().next = graph->outFlows(head).size();
+                    return false;
+                }
+                return true;
             }
-            for(HOFGpath path : pathList) {    
-                for(F flowEdgeInPath : path.pathEdge) {
-                    if(flowEdgeInPath.tail == path.start) {
-                        startEdge = flowEdgeInPath;
-                    }
-                    bool foundLink = false;
-                    for(F f : path.pathEdge) {
-                        if(flowEdgeInPath.head == f.tail) {
-                            foundLink = true;
-                        }
-                    }
-            
-                    if(!foundLink && flowEdgeInPath.head.vertexTy == snk) {
-                        escaped = true;
-                    }
+            void pop() {
+                onPath[stack.back().vertex] = 0;
+                stack.pop_back();
+            }
+        public:
+            void start(const HOFGraph &G, VertexId source, SourceBudget &sourceBudget, long unsigned int &maxEdges) {
+                stop();
+                graph = &G;
+                budget = &sourceBudget;
+                maxPathEdges = &maxEdges;
+                size_t n = G.numVertices();
+                if(onPath.size() < n) {
+                    onPath.resize(n, 0);
                 }
+                stack.reserve(n + 1); //a path holds every vertex at most once, and the source twice
+                stack.push_back(Frame{source, 0, InvalidId, true, false});
+                created = 1;
+                bareSource = G.outFlows(source).empty();
             }
-
-            for(HOFGpath path : pathList) {    
-                for(F flowEdgeInPath : path.pathEdge) {
-                    if(flowEdgeInPath.tail == path.start) {
-                        startEdge = flowEdgeInPath;
-                    }
-                    bool foundLink = false;
-                    for(F f : path.pathEdge) {
-                        if(flowEdgeInPath.head == f.tail) {
-                            foundLink = true;
+            void stop() {
+                while(stack.size() > 1) {
+                    pop();
+                }
+                stack.clear();
+                bareSource = false;
+            }
+            size_t numPaths() const {return created;}
+            size_t numEdges() const {return stack.size() - 1;}
+            bool leakless() const { //The current path reaches a snk node and no edge of it is conditional
+                return stack.back().unconditional && stack.back().freed;
+            }
+            void pathEdges(std::vector<EdgeId> &edges) const { //The edges of the current path, in path order
+                edges.clear();
+                for(size_t i = 1; i < stack.size(); i++) {
+                    edges.push_back(stack[i].in);
+                }
+            }
+            bool next() { //Moves to the next path, false when there is none
+                if(bareSource) {
+                    bareSource = false;
+                    return true;
+                }
+                while(!stack.empty()) {
+                    Frame &top = stack.back();
+                    ArrayRef<EdgeId> out = graph->outFlows(top.vertex);
+                    if(top.next == out.size()) {
+                        if(stack.size() > 1) {
+                            pop();
+                        } else {
+                            stack.clear();
                         }
+                        continue;
                     }
-                    //if(!foundLink && flowEdgeInPath.head.vertexTy != snk && )
-                    if((!foundLink && flowEdgeInPath.head.vertexTy != snk && !escaped) ||
-                    (!foundLink && flowEdgeInPath.head.vertexTy != snk && isa<GlobalVariable>(flowEdgeInPath.head.name))) {
-                        bool definiteEnd = true;
-                        for(F flowInHOFG : HeapOFGraph.flows) {
-                            if(flowInHOFG.tail == flowEdgeInPath.head) {
-                                //errs()<<"\n its working eehhhh.....................................";
-                                definiteEnd = false;
-                            }
-                        }
-                        if(definiteEnd) {
-                            endVertex.insert(flowEdgeInPath.head);
-                            endEdges.insert(flowEdgeInPath);
-                            locAndFile lf;
-                            //flowEdgeInPath.head.name->dump();
-                            //flowEdgeInPath.tail.name->dump();
-                            //errs()<<"\n,,,,,,,,,,,";
-                            if(isa<DebugLoc>(flowEdgeInPath.location)) {
-                                lf.loc = flowEdgeInPath.location.getLine();
-                                auto *Scop = cast<DIScope>(flowEdgeInPath.location->getScope());
-                                lf.fileName = Scop->getFilename().str();
-                                if(lf.loc > 0 ) {
-                                endLocations.insert(lf);
-                                }
-                            }
+                    uint32_t branch = top.next++;
+                    if(branch > 0) { //a later out-edge starts a new path from the frames below, the out-edges of the source always do
+                        if(stack.size() > 1 && !budget->allowPaths(created)) {
+                            continue;
                         }
+                        created++;
                     }
-                    if(!foundLink && flowEdgeInPath.head.vertexTy == snk && flowEdgeInPath.conditions.size()>0) {
-                        if(isa<DebugLoc>(flowEdgeInPath.location)) {
-                            locAndFile lf;
-                            lf.loc = flowEdgeInPath.location.getLine();
-                            auto *Scop = cast<DIScope>(flowEdgeInPath.location->getScope());
-                            lf.fileName = Scop->getFilename().str();
-                            if(lf.loc > 0 ) {
-                                mayLeakEnds.insert(lf);
-                            }
-                        }
+                    EdgeId e = out[branch];
+                    if(!extend(e) || graph->outFlows(graph->flowHead[e]).empty()) {
+                        return true;
                     }
                 }
+                return false;
             }
-            if(pathList.size() == 1) {
-                HOFGpath path = *(pathList.begin());
-                if(path.pathEdge.size() == 0) {
-                    Instruction *allocationInst = dyn_cast<Instruction>(path.start.name);
-                    DebugLoc locdata;
-                    if(allocationInst->getDebugLoc()) {
-                        errs()<<"\nUnused allocation at : ";
-                        locdata = allocationInst->getDebugLoc();
-                        auto *Scopee = cast<DIScope>(locdata->getScope());
-                        std::string fileNamestart = Scopee->getFilename().str();
-                        errs()<<locdata.getLine()<<" in file "<<fileNamestart<<"\n";
-                    }
+        };
+        struct LeakTask { //Scratch state of one worker of the leak analysis, which only reads the graph and the leak facts
+            std::vector<unsigned> visitedBy; //source stamp of the forward walk
+            std::vector<VertexId> stack;
+            PathEnumerator witnessPaths;
+            long unsigned int maxPathEdges = 0;
+            ScratchArena scratch; //temporaries of the source in hand, reset when it is done
+        };
+        struct WitnessPath { //Of a reported obj node, found on the pool and printed after it
+            std::vector<EdgeId> edges; //in path order
+            bool found = false;
+            budgetKind exhausted = noBudget;
+        };
+        typedef std::set<F, std::less<F>, ScratchAllocator<F>> ScratchEdgeSet;
+        struct ScratchLocation { //A location of leakGraph, as line and file string id
+            uint32_t line, file;
+            bool operator == (const ScratchLocation &other) const {return line == other.line && file == other.file;}
+        };
+        typedef std::vector<ScratchLocation, ScratchAllocator<ScratchLocation>> ScratchLocations;
+        void addLocations(ScratchLocations &locations, std::set<locAndFile> &into) { //Each location once, as a locAndFile
+            const LeakGraph &G = leakGraph;
+            std::sort(locations.begin(), locations.end(), [&G](const ScratchLocation &a, const ScratchLocation &b) {
+                return a.line < b.line || (a.line == b.line && G.string(a.file) < G.string(b.file));
+            });
+            locations.erase(std::unique(locations.begin(), locations.end()), locations.end());
+            for(const ScratchLocation &location : locations) {
+                locAndFile lf;
+                if(locationOf(location.line, location.file, lf)) {
+                    into.insert(lf);
                 }
             }
-            if(mayLeakEnds.size()>0) {
-                outs()<<"\n count may leak\n";
+        }
+        Value *allocationOfCast(Value *value) { //Allocation a bitcast is taken of, looking through up to three operands
+            BitCastInst *btc = dyn_cast<BitCastInst>(value);
+            if(!btc) {
+                return nullptr;
             }
-
-            errs()<<"\n ..................may leak ends..............................."<<mayLeakEnds.size()<<"\n";
-            //if(freed) {
-            //    errs()<<"\nEnd points : 0";
-            //    auto *Scopee = cast<DIScope>(startEdge.location->getScope());
-            //    std::string fileNamestart = Scopee->getFilename().str();
-            //    startEdge.tail.name->dump();
-            //    startEdge.head.name->dump();
-            //    errs()<<"\nFor allocation starting from line : "<<startEdge.location.getLine()<<" in file "<<fileNamestart<<"\n";
-            //    
-            //} else {
-                
-                
-                if(endEdges.size() > 0) {
-                    Instruction *allocationInst;
-                    DebugLoc locdata;
-                    locdata = startEdge.location;
-                    if((allocationInst = dyn_cast<Instruction>(startEdge.head.name))){
-                        if(allocationInst->getDebugLoc()) {
-                            locdata = allocationInst->getDebugLoc();
-                        }
-                    } else if((allocationInst = dyn_cast<Instruction>(startEdge.tail.name))) {
-                       if(allocationInst->getDebugLoc()) {
-                           locdata = allocationInst->getDebugLoc();
-                       }
-                    }
-                    auto *Scopee = cast<DIScope>(locdata->getScope());
-                    std::string fileNamestart = Scopee->getFilename().str();
-                    
-                    
-                    if(locdata.getLine()>0) {
-                        startEdge.tail.name->dump();
-                    startEdge.head.name->dump();
-                    errs()<<"\nFor allocation starting from line : "<<locdata.getLine()<<" in file "<<fileNamestart<<"\n";
-                    //errs()<<"\nEnd edges points : "<<endEdges.size()<<"\n";
-                    //errs()<<"\nEnd vertices numbers : "<<endVertex.size()<<"\n";
-                    errs()<<"\nEnd locations :" << endLocations.size()<<"\n";
-                    //startEdge.tail.name->dump();
-                    //startEdge.head.name->dump();
-                    for(locAndFile lf : endLocations) {
-                        errs()<<"\n In line : "<<lf.loc<<" of file : "<<lf.fileName<<".....\n";
-                        outs()<<"\n In line : "<<lf.loc<<" of file : "<<lf.fileName<<".....\n";
-                    }
-                    //for(V endV : endVertex) {
-                    //    endV.name->dump();
-                    //}
-                    errs()<<"\n.....................................................................\n";
-                    outs()<<"\n.....................................................................\n";
-                    }
+            Instruction *ins = dyn_cast<Instruction>(btc->getOperand(0));
+            for(int depth = 0; ins && depth < 3; depth++) {
+                if(isMallocFunction(*ins)) {
+                    return ins;
                 }
-            //}
-            //errs()<<".................................................................................................\n";
-        }
-        void getMayLeakPaths() {
-            std::list<HOFGpath> pathListCopy = pathList;
-            std::list<HOFGpath>::iterator p=pathListCopy.begin();
-            std::list<HOFGpath>::iterator pnext=pathListCopy.begin();
-            int n=pathListCopy.size();
-            while(n>1) {
-                bool status = false;
-                for(F edge : (*p).pathEdge) {
-                    if(edge.head.vertexTy == snk) {
-                        status=true;
-                        break;
-                    }
-                }
-                if(status) {
-                    pnext=p++;
-                    pathListCopy.erase(p);
-                    n--;
-                    p=pnext;
-                } else {
-                    p++;
-                    n--;
+                if(ins->getNumOperands() == 0) {
+                    break;
                 }
+                ins = dyn_cast<Instruction>(ins->getOperand(0));
             }
-            if(n==1) {
-                bool status = false;
-                for(F edge : (*p).pathEdge) {
-                    if(edge.head.vertexTy == snk) {
-                        status=true;
-                        break;
-                    }
+            return nullptr;
+        }
+        bool isEscapeVertex(Value *value) { //The pointer leaves the function or is stored where the analysis does not follow
+            if(isa<Argument>(value) || isa<ReturnInst>(value) || isa<GlobalVariable>(value)) {
+                return true;
+            }
+            if(BitCastInst *btc = dyn_cast<BitCastInst>(value)) {
+                if(isa<GlobalVariable>(btc->getOperand(0))) {
+                    return true;
                 }
-                if(status) {
-                    pathListCopy.erase(p);
+            }
+            for(User *U : value->users()) {
+                if(isa<ReturnInst>(U)) {
+                    return true;
                 }
             }
-            errs()<<"\nNumber of may leak paths : "<<pathList.size() - pathListCopy.size();
+            return false;
         }
-
-        void pruneLeakLessPathsSet() {
-            std::set<HOFGpath>::iterator p=pathSet.begin();
-            int n=pathSet.size();
-            while(n>1) {
-                bool status = false;
-                for(F edge : (*p).pathEdge) {
-                    if(edge.head.vertexTy == snk && edge.conditions.size()==0) {
-                        status=true;
-                        break;
-                    }
+        /*
+        Function : condenseLeakGraph
+        Tarjan's algorithm over leakGraph with an explicit stack, so a long chain of copies does not overflow the
+        call stack. The SCCs come out successors first, which is the order computeLeakFacts needs.
+        Output : sccOfVertex, and the members of SCC c in sccMembers[sccBegin[c]..sccBegin[c+1])
+        */
+        void condenseLeakGraph() {
+            const LeakGraph &G = leakGraph;
+            size_t n = G.numVertices();
+            std::vector<uint32_t> index(n, InvalidId), lowLink(n);
+            std::vector<VertexId> sccStack;
+            std::vector<std::pair<VertexId, uint32_t>> dfsStack; //vertex and position of its next out edge
+            uint32_t nextIndex = 0;
+            sccOfVertex.assign(n, InvalidId);
+            sccBegin.assign(1, 0);
+            sccMembers.clear();
+            auto visit = [&](VertexId v) {
+                index[v] = lowLink[v] = nextIndex++;
+                sccStack.push_back(v);
+                dfsStack.push_back(std::make_pair(v, 0u));
+            };
+            for(VertexId root = 0; root < n; root++) {
+                if(index[root] != InvalidId) {
+                    continue;
                 }
-                if(status) {
-                    pathSet.erase(p);
-                    n--;
+                visit(root);
+                while(!dfsStack.empty()) {
+                    VertexId v = dfsStack.back().first;
+                    ArrayRef<EdgeId> out = G.outFlows(v);
+                    if(dfsStack.back().second < out.size()) {
+                        VertexId w = G.edges[out[dfsStack.back().second++]].head;
+                        if(index[w] == InvalidId) {
+                            visit(w);
+                        } else if(sccOfVertex[w] == InvalidId) { //on the SCC stack
+                            lowLink[v] = std::min(lowLink[v], index[w]);
+                        }
+                        continue;
+                    }
+                    dfsStack.pop_back();
+                    if(!dfsStack.empty()) {
+                        VertexId parent = dfsStack.back().first;
+                        lowLink[parent] = std::min(lowLink[parent], lowLink[v]);
+                    }
+                    if(lowLink[v] == index[v]) {
+                        uint32_t scc = sccBegin.size() - 1;
+                        VertexId member;
+                        do {
+                            member = sccStack.back();
+                            sccStack.pop_back();
+                            sccOfVertex[member] = scc;
+                            sccMembers.push_back(member);
+                        } while(member != v);
+                        sccBegin.push_back(sccMembers.size());
+                    }
                 }
-                p++;
-                n--;
             }
         }
-        
-        void generatePathsFromHOFG() {
-            generateStartOfPaths();
-            long unsigned int initsize = pathList.size();
-            errs()<<"\nThe path list initially have :"<<pathList.size()<<" number of elements";
-            long unsigned int pathCount = 1;
-            std::list<HOFGpath> pathListHeads(pathList);
-            for(HOFGpath path : pathListHeads) {
-                //errs()<<"\nGenarating paths for object node "<< *(path.start.name) <<" in path list";
-                //errs()<<"\nPath  "<<pathList.size();
-                pathList.clear();
-                //copy(pathListHeads.begin(),pathListHeads.end(),pathList.begin());
-                //errs()<<"\nPath list size is "<<pathList.size()<<"\n..";
-                pathList.push_back(path);
-                //errs()<<"\none head added , Path list size is "<<pathList.size()<<"\n..";
-                if(pathCount<=initsize) {
-                    //errs()<<"\nFor object : "<< pathCount << "\n";
-                    int outEdgeCount=0;
-                    HOFGpath newPath=path;
-                    if(path.pathEdge.size() ==0) {
-                        for(F edgeInGraph : HeapOFGraph.flows) {
-                            if(path.start == edgeInGraph.tail) {
-                                if(outEdgeCount == 0) {
-                                    std::list<HOFGpath>::iterator plit;
-                                    newPath=path;
-                                    plit=find(pathList.begin(),pathList.end(),path);
-                                    //errs()<<"\nFrom here 1\n";
-                                    //edgeInGraph.tail.name->dump();errs()<<"-->.";
-                                    //edgeInGraph.head.name->dump();
-                                    addEdgeToList(edgeInGraph,plit);
-                                } else {
-                                    std::list<HOFGpath>::iterator plit;
-                                    pathList.push_back(newPath);
-                                    plit=find(pathList.begin(),pathList.end(),newPath);
-                                    //errs()<<"\nFrom here 2\n";
-                                    //edgeInGraph.head.name->dump();
-                                    addEdgeToList(edgeInGraph,plit);
-                                }
-                                outEdgeCount++;
-                            }
+        static uint64_t addPaths(uint64_t a, uint64_t b) { //Path counts saturate instead of wrapping
+            return a > UINT64_MAX - b ? UINT64_MAX : a + b;
+        }
+        static VertexId joinOrigins(VertexId a, VertexId b) { //none, one allocation, or ManyOrigins
+            return a == InvalidId ? b : (b == InvalidId || a == b) ? a : ManyOrigins;
+        }
+        /*
+        Function : computeLeakFacts
+        Dynamic programming over the condensation of leakGraph, successors first. Every vertex of an SCC reaches
+        every other, so the facts, the cast origin and the path counts are those of the SCC : what its members seed,
+        joined with what the SCCs it has an edge into hold. The conditional free fact needs the reaches sink fact of
+        the edge head, which is final for the SCC itself once its other facts are joined. One pass, O(V+E).
+        Output : leakFacts, castOrigin, pathsToFree and pathsToOpenEnd of every vertex. The path counts are of the
+        paths through the condensation, as a path that goes around a cycle has no count.
+        */
+        void computeLeakFacts() {
+            const LeakGraph &G = leakGraph;
+            size_t n = G.numVertices();
+            condenseLeakGraph();
+            size_t numSCCs = sccBegin.size() - 1;
+            NumLeakGraphSCCs += numSCCs;
+            std::vector<uint8_t> sccFacts(numSCCs, 0);
+            std::vector<VertexId> sccOrigin(numSCCs, InvalidId);
+            std::vector<uint64_t> sccToFree(numSCCs, 0), sccToOpenEnd(numSCCs, 0);
+            for(uint32_t c = 0; c < numSCCs; c++) {
+                ArrayRef<VertexId> members = makeArrayRef(sccMembers.data() + sccBegin[c], sccMembers.data() + sccBegin[c + 1]);
+                uint8_t facts = 0;
+                VertexId origin = InvalidId;
+                uint64_t toFree = 0, toOpenEnd = 0;
+                for(VertexId v : members) {
+                    const LeakVertex &vertex = G.vertices[v];
+                    if(vertex.vertexTy == snk) {
+                        facts |= reachesSink;
+                        toFree = addPaths(toFree, 1);
+                    } else if(G.outFlows(v).empty()) {
+                        facts |= (vertex.flags & globalVertex) ? (reachesOpenEnd | reachesGlobalEnd) : reachesOpenEnd;
+                        toOpenEnd = addPaths(toOpenEnd, 1);
+                    }
+                    if(vertex.flags & escapeVertex) {
+                        facts |= reachesEscape;
+                    }
+                    origin = joinOrigins(origin, vertex.castOf);
+                    for(EdgeId e : G.outFlows(v)) {
+                        const LeakEdge &le = G.edges[e];
+                        uint32_t headSCC = sccOfVertex[le.head];
+                        if(le.conditions != 0 && G.vertices[le.head].vertexTy == snk) {
+                            facts |= reachesGuardedSink;
+                        }
+                        if(headSCC != c) {
+                            facts |= sccFacts[headSCC];
+                            origin = joinOrigins(origin, sccOrigin[headSCC]);
+                            toFree = addPaths(toFree, sccToFree[headSCC]);
+                            toOpenEnd = addPaths(toOpenEnd, sccToOpenEnd[headSCC]);
+                        }
+                    }
+                }
+                //A route to a free that passes a condition anywhere : the freeing is not certain
+                for(VertexId v : members) {
+                    for(EdgeId e : G.outFlows(v)) {
+                        const LeakEdge &le = G.edges[e];
+                        uint32_t headSCC = sccOfVertex[le.head];
+                        if(le.conditions != 0 && ((headSCC == c ? facts : sccFacts[headSCC]) & reachesSink)) {
+                            facts |= reachesConditionalFree;
                         }
                     }
                 }
-                pathCount++;
-                /*Code for finding leaks for one obj node to be written here.*/
-                errs()<<"\nFor source number : "<<pathCount -1 <<" : \n";
-                //path.start.name->dump();
-                pruneLeaklessPathsFromPathHead();
-                //getMayLeakPathsFromPathHead();
-                detectEndsOfPathFromPathHead();
-                //getMayLeakPathsFromPathHead();
-                errs()<<"\nMax path length is: "<<pathedgesSize;
-                //printPathsList();
-                //errs()<<"\n.................................................................";
+                sccFacts[c] = facts;
+                sccOrigin[c] = origin;
+                sccToFree[c] = toFree;
+                sccToOpenEnd[c] = toOpenEnd;
+            }
+            leakFacts.resize(n);
+            castOrigin.resize(n);
+            pathsToFree.resize(n);
+            pathsToOpenEnd.resize(n);
+            for(VertexId v = 0; v < n; v++) {
+                uint32_t c = sccOfVertex[v];
+                leakFacts[v] = sccFacts[c];
+                castOrigin[v] = sccOrigin[c];
+                pathsToFree[v] = sccToFree[c];
+                pathsToOpenEnd[v] = sccToOpenEnd[c];
             }
         }
-        long unsigned int pathedgesSize=0;
-        void addEdgeToList(F edgeToBeAdded, std::list<HOFGpath>::iterator plit) {
-            if(pathedgesSize<(*plit).pathEdge.size())
-            {
-                pathedgesSize=(*plit).pathEdge.size();
+        /*
+        Function : classify one obj node from the leak facts
+        Input : vertex id of the obj node, the facts from computeLeakFacts
+        Output : its verdict, with the end locations when it is reported
+        */
+        SourceVerdict classifySource(VertexId source, unsigned stamp, LeakTask &task) {
+            SourceVerdict sv;
+            sv.source = source;
+            const LeakGraph &G = leakGraph;
+            ArrayRef<EdgeId> startEdges = G.outFlows(source);
+            if(startEdges.empty()) {
+                sv.verdict = unused;
+                return sv;
             }
-            bool circPath = false;
-            for(F presentEdge : (*plit).pathEdge) {
-                if((edgeToBeAdded.head == presentEdge.tail) || (edgeToBeAdded.head == presentEdge.head)) {
-                    circPath = true;
+            sv.startEdge = startEdges.back();
+            uint8_t facts = leakFacts[source];
+            VertexId origin = castOrigin[source];
+            bool escaped = (facts & (reachesEscape | reachesConditionalFree)) ||
+                origin == ManyOrigins || (origin != InvalidId && origin != source);
+            uint8_t endFact = escaped ? reachesGlobalEnd : reachesOpenEnd;
+            uint8_t walkFacts = endFact | reachesGuardedSink;
+            if(facts & walkFacts) {
+                SourceBudget budget(moduleBudget);
+                if(!budget.check()) {
+                    return inconclusiveVerdict(sv, budget);
                 }
-            }
-            if(pathList.size()<1000) {
-            if(!circPath) {
-                (*plit).pathEdge.insert(edgeToBeAdded);
-                int count = 0;
-                HOFGpath newPath = (*plit);
-                for(F edgeInGraph : HeapOFGraph.flows) {
-                    
-                    if(edgeToBeAdded.head == edgeInGraph.tail) {
-                        if(count == 0) {
-                            //errs()<<"\nFrom here 3\n";
-                            //edgeInGraph.head.name->dump();
-                            addEdgeToList(edgeInGraph,plit);
-                        } else {
-                            if(pathList.size() < 1000) {
-                            std::list<HOFGpath>::iterator npit;
-                            HOFGpath nextPath = newPath;
-                            pathList.push_back(newPath);
-                            npit = pathList.end();
-                            npit--;
-                            if(newPath == (*npit)) {
-                                //errs()<<"\nFrom here 4";
-                                //edgeInGraph.head.name->dump();
-                                //errs()<<"\n from here path list size : ";
-                                addEdgeToList(edgeInGraph,npit);
-                            }
+                ScratchArenaReset reset(task.scratch);
+                ScratchLocations endLocations{ScratchAllocator<ScratchLocation>(task.scratch)};
+                ScratchLocations mayLeakEnds{ScratchAllocator<ScratchLocation>(task.scratch)};
+                std::vector<VertexId> &stack = task.stack;
+                std::vector<unsigned> &visitedBy = task.visitedBy;
+                stack.assign(1, source);
+                visitedBy[source] = stamp;
+                while(!stack.empty()) {
+                    VertexId v = stack.back();
+                    stack.pop_back();
+                    for(EdgeId e : G.outFlows(v)) {
+                        if(!budget.spendEdge()) {
+                            return inconclusiveVerdict(sv, budget);
+                        }
+                        const LeakEdge &le = G.edges[e];
+                        VertexId head = le.head;
+                        if(G.vertices[head].vertexTy == snk) {
+                            if(le.conditions != 0) {
+                                mayLeakEnds.push_back(ScratchLocation{le.line, le.file});
                             }
+                        } else if(G.outFlows(head).empty() && (leakFacts[head] & endFact)) {
+                            sv.endEdges++;
+                            endLocations.push_back(ScratchLocation{le.line, le.file});
+                        }
+                        if(visitedBy[head] != stamp && (leakFacts[head] & walkFacts)) {
+                            visitedBy[head] = stamp;
+                            stack.push_back(head);
                         }
-                        count++;
                     }
                 }
+                addLocations(endLocations, sv.endLocations);
+                addLocations(mayLeakEnds, sv.mayLeakEnds);
             }
+            if(sv.endEdges > 0) {
+                sv.verdict = leaks;
+            } else if(sv.mayLeakEnds.size() > 0) {
+                sv.verdict = mayLeak;
+            } else if(escaped) {
+                sv.verdict = escapes;
+            } else {
+                sv.verdict = freed;
             }
-            //errs()<<"\nPath list size : "<<pathList.size()<<"..\n";
+            return sv;
         }
-        void generateStartOfPaths() {
-            for(V vert : HeapOFGraph.vertices) {
-                if(vert.vertexTy == obj) {
-                    HOFGpath newPath;
-                    newPath.start = vert;
-                    //vert.name->dump();
-                    if(find(pathList.begin(),pathList.end(),newPath) != pathList.end()) {
-                        
-                    } else {
-                        pathList.push_back(newPath);
-                    }
+        static SourceVerdict &inconclusiveVerdict(SourceVerdict &sv, const SourceBudget &budget) {
+            sv.verdict = inconclusive;
+            sv.budget = budget.exhausted;
+            sv.endEdges = 0;
+            sv.endLocations.clear();
+            sv.mayLeakEnds.clear();
+            return sv;
+        }
+        /*
+        Function : analyseLeaksFromHOFG
+        Every obj node is classified on its own over the frozen graph, so the obj nodes are tasks of a work-stealing
+        pool of -hofg-threads workers. The verdicts are kept in vertex order of the obj nodes for printLeakReports.
+        */
+        void analyseLeaksFromHOFG() {
+            HOFGStats::Phase phase(stats.get(), HOFGStats::endDetectionPhase);
+            computeLeakFacts();
+            std::vector<VertexId> sources;
+            for(VertexId v = 0; v < leakGraph.numVertices(); v++) {
+                if(leakGraph.vertices[v].vertexTy == obj) {
+                    sources.push_back(v);
+                }
+            }
+            leakVerdicts.assign(sources.size(), SourceVerdict());
+            WorkStealingPool pool(numThreads());
+            std::vector<LeakTask> tasks(pool.size());
+            pool.run(sources.size(), [&](unsigned worker, unsigned i) {
+                LeakTask &task = tasks[worker];
+                if(task.visitedBy.empty()) {
+                    task.visitedBy.assign(leakGraph.numVertices(), 0);
+                }
+                leakVerdicts[i] = classifySource(sources[i], i + 1, task);
+            });
+            NumSourcesClassified += sources.size();
+            for(const SourceVerdict &sv : leakVerdicts) {
+                if(sv.verdict == inconclusive) {
+                    ++NumSourcesInconclusive;
                 }
             }
         }
         /*
-        Function : generate paths from obj to free nodes in the HOFG
-        Input : The HeapOFGraph sturct instance in the program
-        Output : List of paths generated from the graph.
-        A path : a sequence of pointers to the edges in the HeapOFGraph
+        Function : printLeakReports(err, out)
+        Prints the verdicts of analyseLeaksFromHOFG, with the witness paths of the reported obj nodes for
+        -hofg-witness-paths. Each report is formatted in its own buffers on the pool, which also finds the witness
+        paths, and printed in order, so the output does not depend on the number of threads. The witness paths
+        print IR values, which neither Value::print nor ModuleSlotTracker allows from several threads, so they are
+        formatted after the pool, as the reports are printed. Only reads the graph and the verdicts.
         */
-        void generatePaths() {
-            generatePathHeads();
-            errs()<<"\nPathheads generated. \n";
-            int count=0;
-            std::set<HOFGpath>::iterator psit;
-            outs()<<"\nInitially path heads count:"<<pathSet.size()<<"\n";
-            errs()<<"\nInitially path heads count:"<<pathSet.size()<<"\n";
-            for(HOFGpath p : pathSet) {
-                HOFGpath newPath=p;
-                errs()<<"\npathSet count becomes :"<<pathSet.size()<<"\n";
-                if(pathSet.size()>1000) {
-                    break;
+        void printLeakReports(raw_ostream &errStream, raw_ostream &outStream) {
+            HOFGStats::Phase phase(stats.get(), HOFGStats::pathPhase);
+            std::vector<std::string> errReports(leakVerdicts.size()), outReports(leakVerdicts.size());
+            WorkStealingPool pool(numThreads());
+            std::vector<WitnessPath> witnesses(HOFGWitnessPaths ? leakVerdicts.size() : 0);
+            auto hasWitness = [this](const SourceVerdict &sv) {
+                return HOFGWitnessPaths && !savedGraphMapping && (sv.verdict == leaks || sv.verdict == mayLeak);
+            };
+            std::vector<LeakTask> tasks(pool.size());
+            pool.run(leakVerdicts.size(), [&](unsigned worker, unsigned i) {
+                const SourceVerdict &sv = leakVerdicts[i];
+                raw_string_ostream err(errReports[i]), out(outReports[i]);
+                printLeakVerdict(sv, i + 1, err, out);
+                if(hasWitness(sv)) {
+                    findWitnessPath(sv.source, tasks[worker], witnesses[i]);
                 }
-                
-                count=0;
-                
-                if(p.pathEdge.size() == 0) {
-                    for(F flowEdge : HeapOFGraph.flows) {
-                        if(flowEdge.tail == p.start) {
-                            psit=pathSet.find(p);
-                            if(count == 0) {
-                                newPath = p;
-                                addToPath(flowEdge, psit);
-                            } else if(count > 0) {
-                                errs()<<"Two paths from";
-                                newPath.start.name->dump();
-                                std::set<HOFGpath>::iterator pitl;
-                                pathSet.insert(newPath);
-                                pitl=pathSet.find(newPath);
-                                //newPath=(*pitl);
-                                addToPath(flowEdge,pitl);
-                            }
-                            count++;
-                        }
-                    }
+            });
+            errStream<<"\nThe path list initially have :"<<leakVerdicts.size()<<" number of elements";
+            ValuePrinter printer;
+            ScratchArena scratch;
+            for(size_t i = 0; i < leakVerdicts.size(); i++) {
+                errStream<<errReports[i];
+                outStream<<outReports[i];
+                if(hasWitness(leakVerdicts[i])) {
+                    printWitnessPath(leakVerdicts[i].source, witnesses[i], scratch, printer, outStream);
+                }
+            }
+            std::string budgetReport;
+            raw_string_ostream budgets(budgetReport);
+            unsigned numInconclusive = 0;
+            for(const SourceVerdict &sv : leakVerdicts) {
+                if(sv.verdict == inconclusive) {
+                    numInconclusive++;
+                    budgets<<"\n "<<allocationSite(sv.source)<<" : "<<budgetName(sv.budget)<<" budget\n";
+                }
+            }
+            if(numInconclusive > 0) { //Which allocation sites hit which budget
+                errStream<<"\nInconclusive allocations : "<<numInconclusive<<"\n"<<budgets.str();
+                outStream<<"\nInconclusive allocations : "<<numInconclusive<<"\n"<<budgets.str();
+            }
+        }
+        std::string allocationSite(VertexId source) const { //Location of an obj node, or its instruction without one
+            const LeakVertex &allocation = leakGraph.vertices[source];
+            if(allocation.flags & locatedVertex) {
+                return ("Allocation at line " + Twine(allocation.line) + " in file " + leakGraph.string(allocation.file)).str();
+            }
+            return ("Allocation " + leakGraph.string(allocation.text).ltrim()).str();
+        }
+        static unsigned numThreads() {
+            return HOFGThreads ? (unsigned)HOFGThreads : hardware_concurrency().compute_thread_count();
+        }
+        void printLeakVerdict(const SourceVerdict &sv, unsigned sourceNumber, raw_ostream &err, raw_ostream &out) {
+            err<<"\nFor source number : "<<sourceNumber<<" : \n";
+            const LeakGraph &G = leakGraph;
+            if(sv.verdict == inconclusive) {
+                err<<"\nInconclusive : the "<<budgetName(sv.budget)<<" budget ran out for the "<<allocationSite(sv.source)<<"\n";
+                return;
+            }
+            if(sv.verdict == unused) {
+                const LeakVertex &allocation = G.vertices[sv.source];
+                if(allocation.flags & locatedVertex) {
+                    err<<"\nUnused allocation at : "<<allocation.line<<" in file "<<G.string(allocation.file)<<"\n";
                 }
             }
+            if(sv.mayLeakEnds.size()>0) {
+                out<<"\n count may leak\n";
+            }
+            err<<"\n ..................may leak ends..............................."<<sv.mayLeakEnds.size()<<"\n";
+            if(sv.endEdges == 0) {
+                return;
+            }
+            const LeakEdge &startEdge = G.edges[sv.startEdge];
+            const LeakVertex &tail = G.vertices[startEdge.tail], &head = G.vertices[startEdge.head];
+            locAndFile start;
+            const LeakVertex *located = (head.flags & locatedVertex) ? &head : (tail.flags & locatedVertex) ? &tail : nullptr;
+            if(!(located ? locationOf(located->line, located->file, start) : locationOf(startEdge.line, startEdge.file, start))) {
+                return;
+            }
+            err<<G.string(tail.text)<<"\n"; //as Value::dump
+            err<<G.string(head.text)<<"\n";
+            err<<"\nFor allocation starting from line : "<<start.loc<<" in file "<<start.fileName<<"\n";
+            err<<"\nEnd locations :" << sv.endLocations.size()<<"\n";
+            for(const locAndFile &lf : sv.endLocations) {
+                err<<"\n In line : "<<lf.loc<<" of file : "<<lf.fileName<<".....\n";
+                out<<"\n In line : "<<lf.loc<<" of file : "<<lf.fileName<<".....\n";
+            }
+            err<<"\n.....................................................................\n";
+            out<<"\n.....................................................................\n";
         }
-        void addToPath(F flowEdge,std::set<HOFGpath>::iterator psit) {
-            (*psit).pathEdge.insert(flowEdge);
-            int count =0;
-            HOFGpath oldPath = (*psit);
-            for(F edgeInGraph : HeapOFGraph.flows) {
-                if(flowEdge.head == edgeInGraph.tail) {
-                    if(count == 0) {
-                        //oldPath = (*psit);
-                        addToPath(edgeInGraph,psit);
-                    } else {
-                        oldPath.pathEdge.insert(edgeInGraph);
-                        pathSet.insert(oldPath);
-                        //if(pathSet.insert(oldPath).second) {
-                        //
-                        //} else {
-                        //errs()<<"\n this is not happening";
-                        //}
-                        //psit=pathSet.find(oldPath);
-                        //addToPath(edgeInGraph,psit);
-                    }   
-                    count++;
-                }
-            }
-        }
-        void generatePathHeads() {
-            for(F edgeInGraph : HeapOFGraph.flows) {
-                V vertex = edgeInGraph.tail;
-                if(vertex.vertexTy == obj) {
-                    HOFGpath p;
-                    p.start = vertex;
-                    //vertex.name->dump();
-                    pathSet.insert(p);
-                    //errs()<<"\npathHead added for path set count :"<<pathSet.size()<<"\n";
-                }
-            }
-        }
-        void detectResidueErrorType() {
-            for(HOFGpath p : pathSet) {
-                bool status = false;
-                if(p.pathEdge.size() == 0) {
-                    outs()<<"\nUnused allocation at: ";
-                    unsigned loc = (dyn_cast<Instruction>(p.start.name))->getDebugLoc().getLine();
-                    outs()<<"\nline number : "<<loc<<"\n";
-                    const DebugLoc &location = (dyn_cast<Instruction>(p.start.name))->getDebugLoc();
-                    auto *Scope = cast<DIScope>(location->getScope());
-                    std::string fileName = Scope->getFilename().str();
-                    outs()<<"in file : "<<fileName<<"\n";
-                } else {
-                for(F f1 : p.pathEdge) {
-                    status=false;
-                    for(F f2 : p.pathEdge) {
-                        if(f1.head == f2.tail) {
-                            status=true;
-                        }
-                    }
-                    if(!status) {
-                        outs()<<"\nDangling pointer at";
-                        unsigned loc = f1.location.getLine();
-                        outs()<<"\n line number : "<<loc<<"\n";
-                        auto *Scope = cast<DIScope>(f1.location->getScope());
-                        std::string fileName = Scope->getFilename().str();
-                        outs()<<"in file : "<<fileName<<"\n";
-                    }
+        void findWitnessPath(VertexId source, LeakTask &task, WitnessPath &witness) { //Enumerate the paths of one reported obj node, for -hofg-witness-paths
+            //Leakless paths are pruned as they are enumerated, and the first path that is not is the witness of the
+            //leak : the verdict is final there and the enumeration stops
+            SourceBudget budget(moduleBudget);
+            PathEnumerator &paths = task.witnessPaths;
+            paths.start(HeapOFGraph, source, budget, task.maxPathEdges);
+            while(paths.next()) {
+                if(paths.leakless()) {
+                    ++NumPathsPruned;
+                    continue;
                 }
+                paths.pathEdges(witness.edges);
+                witness.found = true;
+                break;
+            }
+            NumPathsGenerated += paths.numPaths();
+            paths.stop();
+            witness.exhausted = budget.exhausted;
+        }
+        void printWitnessPath(VertexId source, const WitnessPath &witness, ScratchArena &scratch, ValuePrinter &printer, raw_ostream &out) {
+            if(witness.found) {
+                ScratchArenaReset reset(scratch);
+                ScratchEdgeSet pathEdge{ScratchAllocator<F>(scratch)}; //printed in the order of F, as the path sets were
+                for(EdgeId e : witness.edges) {
+                    pathEdge.insert(HeapOFGraph.flows[e]);
                 }
+                printPath(HeapOFGraph.vertex(source), pathEdge, out, printer);
+            }
+            if(witness.exhausted != noBudget) {
+                out<<"\n Witness paths truncated : the "<<budgetName(witness.exhausted)<<" budget ran out, of "
+                    <<addPaths(pathsToFree[source], pathsToOpenEnd[source])<<" paths through the condensed HOFG\n";
             }
         }
+
         void constructHOFG(Function &F) {
             //for(Module::iterator MI=M.begin();MI!=M.end();++MI) {
             //    Function &F(*MI);
                 constructHOFGfun(F);
             //}
         }
-        void generateSummary(Module &M) {
-            for(Module::iterator MI=M.begin();MI!=M.end();++MI) {
-                Function &F(*MI);
-                if(F.getName() == "xmalloc" || F.getName() == "xcalloc") {
-
-                } else {
-                    generateFunctionSummary(F);
-                }
-            }
-        }
         void generateFunctionSummary(Function &F) { //generate HOFG of the function                
                 if(F.isDeclaration()) {
 
-                } else if(F.getName() == "xmalloc" || F.getName() == "xcalloc"){
+                } else if(calleeFlags(&F) & wrapperCallee){
 
                 } else /*if (!(F.hasMetadata("summary")))*/{
                 //errs()<<"Generating summary of : "<<F.getName()<<"\n\n";
-                FuncSummary summary;
-                summary.funcName = &F;
-                for(Argument &A : F.args()) {
-                    Value *argValue = dyn_cast<Value>(&A);
-                    summary.formalArgs.insert(argValue);
-                }
-                summary.retType= F.getReturnType();
-                allFuncSummaries.insert(summary);
-                LLVMContext& C=F.getContext();
-                MDNode* N=MDNode::get(C, MDString::get(C,"summary generated"));
-                F.setMetadata("summary",N);
+                FuncSummary *fsit = summaryOf(&F); //added by summariseCallGraph, the table is shared by the builders
+                if(!fsit) {
+                    return;
+                }
+                fsit->generated = true; //"summary" metadata is attached after the summaries are built
+                Function *outerContext = HeapOFGraph.lookupContext;
+                HeapOFGraph.lookupContext = &F;
                 constructHOFGfun(F);
+                HeapOFGraph.lookupContext = outerContext;
                 //summary.argTransforms = ; Is updated while constructHOFGfun(F) above.
                 //summary.functionType = ;
-                if(allFuncSummaries.find(summary)!=allFuncSummaries.end()) {
-                    fsit=allFuncSummaries.find(summary);
-                    if(fsit->argTransforms.size() < 1) {
-                        fsit->functionType=noop;
-                    } else {
-                        if((find(fsit->argTransforms.begin(), fsit->argTransforms.end(), allocator) != fsit->argTransforms.end()) && 
-                        find(fsit->argTransforms.begin(), fsit->argTransforms.end(), deallocator) != fsit->argTransforms.end()) {
-                            fsit->functionType=allocdealloc;
-                        } else if ((find(fsit->argTransforms.begin(), fsit->argTransforms.end(), deallocator) != fsit->argTransforms.end())){
-                            fsit->functionType=deallocator;
-                        } else if (find(fsit->argTransforms.begin(), fsit->argTransforms.end(), allocator) != fsit->argTransforms.end()) {
-                            fsit->functionType=allocator;
-                        }
-                    }
+                uint8_t transforms = fsit->allTransforms();
+                if(transforms == 0) {
+                    fsit->functionType=noop;
+                } else if(transforms == (allocatesArg | deallocatesArg)) {
+                    fsit->functionType=allocdealloc;
+                } else if(transforms == deallocatesArg) {
+                    fsit->functionType=deallocator;
+                } else {
+                    fsit->functionType=allocator;
                 }
                 
                 }
         }
         void constructHOFGfun(Function &F) {
             if(! F.isDeclaration()) {
-                FuncSummary newFunc;
-                newFunc.funcName=&F;
-                newFunc.retType=F.getReturnType();
-                for (auto& A : F.args()) {
-                    newFunc.formalArgs.insert(&A);
-                }
-                //Following for loop is to record preds of bbs and conditions
-                for(Function::iterator FI=F.begin(); FI!=F.end(); FI++) {
-                    BasicBlock &B(*FI);
-                    predBB newPredSet;
-                    newPredSet.bb=&B;
-                    auto bt=pred_begin(&B);
-                    auto et=pred_end(&B);
-                    for (bt = pred_begin(&B), et = pred_end(&B); bt != et; ++bt)
-                    {
-                        BasicBlock* predecessor = *bt;
-                        Instruction* terminator = predecessor->getTerminator();
-                        if(isa<BranchInst>(terminator)) {
-                            BranchInst* br = dyn_cast<BranchInst>(terminator);
-                            if(br->isConditional()) {
-                                Value *cond= br->getCondition();
-                                for(BasicBlock* s : br->successors()) {
-                                    if(s->getName() == B.getName()) {
-                                        newPredSet.entriConditions.insert(cond);
-                                    }
-                                }
-                            }
-                        }
-                        newPredSet.preds.insert(predecessor);
-                        predBB ifExistPreds;
-                        ifExistPreds.bb = predecessor;
-                        if(allBBs.find(ifExistPreds) != allBBs.end()) {
-                            ifExistPreds = *(allBBs.find(ifExistPreds));
-                            for(BasicBlock *p : ifExistPreds.preds) {
-                                newPredSet.preds.insert(p);
-                            }
-                            for (Value *c : ifExistPreds.entriConditions) {
-                                newPredSet.entriConditions.insert(c);
-                            }
-                        }
-                    }
-                    allBBs.insert(newPredSet);
+                //The conditions guarding each block come from guardingConditions, computed on the first pass over F
+                for(const HandlerStep &step : handlerPlan(F)) {
                     /*
-                    Function : idRelevantCodeSegment(BasicBlock B)
-                    Input : Basic Block
-                    Output : Identify the code segments in Basic Block that complies to the rules in the algorithm and invoke corresponding handlers
+                    Function : runHandler(step)
+                    Input : a code segment that complies to the rules in the algorithm, from the handler plan of F
+                    Output : its handler adds the vertices and edges to HOFG
                     */
-                    idRelevantCodeSegment(B);
+                    runHandler(step);
                 }
             }
         }
-
-        void idRelevantCodeSegment(BasicBlock &B) {//Detects the relevent code segment that needs action in the algorithm
-            for(BasicBlock::iterator BI=B.begin(); BI!=B.end(); BI++) {
-                Instruction &I(*BI);
-                if(isMallocFunction(I)) {
-                    handleRelevantCodeSegment(MEM_ALLOC, B, I);                    
-                }
-                if(isFreeFunction(I)) {
-                    handleRelevantCodeSegment(MEM_DEALLOC, B, I);
-                }
-                if(identifyCopyInstruction(I)) {
-                    handleRelevantCodeSegment(K_COPY, B, I);
-                }
-                if(identifyLoadInstruction(I)) {
-                    handleRelevantCodeSegment(LK_DEREF,B, I);
-                }
-                if(identifyStoreInstruction(I)) {
-                    handleRelevantCodeSegment(STORE,B, I);
+        /*
+        Handler plan of a function : its code segments that are relevant to the algorithm, as the handler each one
+        needs, in instruction order. HandlerClassifier finds them with one visit of each instruction on the first
+        pass over the function; the later passes of the fixpoint run the plan without classifying again.
+        Shared by the summary builders, as the guards are.
+        */
+        typedef void (HOFG::*Handler)(BasicBlock &B, Instruction &I);
+        struct HandlerStep {
+            Instruction *I;
+            Handler handler;
+            int option; //code of the handler in HOFG.def, for the statistics
+        };
+        typedef std::vector<HandlerStep> HandlerPlan;
+        struct PlanCache {
+            DenseMap<const Function*, std::unique_ptr<HandlerPlan>> functions;
+            std::mutex lock;
+        }ownPlans;
+        PlanCache &Plans;
+        const HandlerPlan &handlerPlan(Function &F) {
+            {
+                std::lock_guard<std::mutex> guard(Plans.lock);
+                auto it = Plans.functions.find(&F);
+                if(it != Plans.functions.end()) {
+                    return *it->second;
                 }
-                if(identifyDeallocation(I)) {
-                    handleRelevantCodeSegment(DEREF, B, I);
+            }
+            std::unique_ptr<HandlerPlan> plan(new HandlerPlan());
+            HandlerClassifier(*this, *plan).visit(F);
+            std::lock_guard<std::mutex> guard(Plans.lock);
+            std::unique_ptr<HandlerPlan> &slot = Plans.functions[&F];
+            if(!slot) { //another builder may have planned F meanwhile, the plans are the same
+                slot = std::move(plan);
+            }
+            return *slot;
+        }
+        /*
+        HandlerClassifier : the handler steps of each instruction, from one dispatch on its opcode. An instruction
+        may need several handlers, as a call to a defined allocator wrapper or a bitcast of a GEP does; they are
+        planned in the order of the handler codes.
+        */
+        struct HandlerClassifier : public InstVisitor<HandlerClassifier> {
+            const HOFG &pass;
+            HandlerPlan &plan;
+            HandlerClassifier(const HOFG &pass, HandlerPlan &plan) : pass(pass), plan(plan) {}
+            void add(Instruction &I, Handler handler, int option) {
+                plan.push_back(HandlerStep{&I, handler, option});
+            }
+            void visitCallInst(CallInst &I) {
+                uint8_t flags = pass.calleeFlags(I.getCalledFunction());
+                if(flags & (allocatorCallee | wrapperCallee)) {
+                    add(I, &HOFG::addMalloc, MEM_ALLOC);
                 }
-                if(isa<PHINode>(I)) {
-                    handleRelevantCodeSegment(PHI_COPY, B, I);
+                if(flags & deallocatorCallee) {
+                    add(I, &HOFG::addDealloc, MEM_DEALLOC);
                 }
-                if(identifyFunctionCall(I)) {
-                    handleRelevantCodeSegment(FUNC_CALL, B, I);
+                if(flags & definedCallee) {
+                    add(I, &HOFG::applyFunctionSummary, FUNC_CALL);
                 }
-                if(identifyReturn(I)) {
-                    handleRelevantCodeSegment(RET,B,I);
+            }
+            void visitLoadInst(LoadInst &I) { //copy out of a known pointer
+                if(!isa<GetElementPtrInst>(I.getOperand(0)) && isa<PointerType>(I.getType())) {
+                    add(I, &HOFG::addCopy, K_COPY);
                 }
-                if(identifyBitCast(I)) {
-                    handleRelevantCodeSegment(BIT_CAST,B,I);
+            }
+            void visitStoreInst(StoreInst &I) {
+                if(isa<PointerType>(I.getOperand(0)->getType())) {
+                    add(I, &HOFG::addStoreToDereference, STORE);
                 }
-                if(identifyBitCastCopy(I)) {
-                    handleRelevantCodeSegment(GEP_BIT,B,I);
+            }
+            void visitPHINode(PHINode &I) {
+                add(I, &HOFG::addPhiInstruction, PHI_COPY);
+            }
+            void visitReturnInst(ReturnInst &I) {
+                if(I.getNumOperands() > 0) {
+                    add(I, &HOFG::addReturn, RET);
                 }
-               // handleRelevantCodeSegment(I.getOpcode(), B);
             }
-        }
-        bool isMallocFunction(Instruction &I) {
-            //I.dump();
-            //if(isa<BitCastInst>(I)) {
-                if(isa<CallInst>(I)) {
-                    CallInst *call=dyn_cast<CallInst>(&I);
-                    //if(isa<Function>(call->getCalledFunction())) {
-                    if(call->getCalledFunction() == NULL) {
-                        return false;
-                    }
-                    if(Function *F = dyn_cast<Function>(call->getCalledFunction())) {
-                        //Function *F = call->getCalledFunction();
-                        //F->dump();
-                        if(F->hasName()) {
-                            //errs()<<F->getName();
-                            //errs()<<"\n";
-                            if(F->getName() == MALLOC|| F->getName() == "u_calloc" || F->getName() == "calloc" || F->getName() == "realloc") {
-                                return true;
-                            } else if (F->getName() ==  "xmalloc" || F->getName() == "xcalloc") {
-                                //F->setName("malloc");
-                                return true;
-                            }
-                        }  else {
-                        }
+            void visitBitCastInst(BitCastInst &I) {
+                if(isa<PointerType>(I.getOperand(0)->getType())) {
+                    add(I, &HOFG::addCopy, BIT_CAST);
+                    if(isa<GetElementPtrInst>(I.getOperand(0))) {
+                        add(I, &HOFG::addGepToBitcast, GEP_BIT);
                     }
                 }
-            //}
-            return false;
-        }
-        bool identifyFunctionCall(Instruction &I) {
-            //if(isa<BitCastInst>(I)) {
-                if(isa<CallInst>(I)) {
-                    CallInst *call=dyn_cast<CallInst>(&I);
-                    //if(call->hasName()) {
-                        if(call->getCalledFunction() == NULL) {
-                           return false;
-                        }
-                        Function *F = call->getCalledFunction();
-                        if(! F->isDeclaration()) {
-                            return true;
-                        }
-                    //} else {
-                    //}
+            }
+        };
+        /*
+        Callee table : what each function of the module is to the handlers, resolved once per module by
+        buildCalleeTable, so classifying a call is one lookup. A function may be both defined and an allocator,
+        a defined wrapper is handled as an allocator and as a call. External functions have no entry.
+        */
+        enum calleeFlag {definedCallee = 1, allocatorCallee = 2, deallocatorCallee = 4, wrapperCallee = 8};
+        struct CalleeTable {
+            DenseMap<const Function*, uint8_t> flags;
+            std::string names; //the configured names, part of the summary cache key
+        }ownCallees;
+        CalleeTable &Callees; //shared with the summary builders
+        /*
+        Function : buildCalleeTable(M, error)
+        Output : the callee table of M, from the default names, -hofg-allocator, -hofg-deallocator,
+        -hofg-allocator-wrapper and -hofg-allocator-file. False with error if the file cannot be read.
+        */
+        bool buildCalleeTable(Module &M, std::string &error) {
+            AllocatorNames names;
+            names.allocators = {MALLOC, "u_calloc", "calloc", "realloc"};
+            names.deallocators = {FREE};
+            names.wrappers = {"xmalloc", "xcalloc"};
+            if(!HOFGAllocatorFile.empty()) {
+                ErrorOr<std::unique_ptr<MemoryBuffer>> buffer = MemoryBuffer::getFile(HOFGAllocatorFile);
+                if(!buffer) {
+                    error = buffer.getError().message();
+                    return false;
                 }
-            //}
-            return false;
-        }
-
-        bool isFreeFunction(Instruction &I) {
-            //if(isa<BitCastInst>(I)) {
-                if(isa<CallInst>(I)) {
-                    CallInst *call=dyn_cast<CallInst>(&I);
-                    Function *F = call->getCalledFunction();
-                    //if(call->hasName()) {
-                        //errs()<<F->getName();
-                        if(call->getCalledFunction() == NULL) {
-                           return false;
-                        }
-                        if(F->getName() == FREE) {
-                            //errs()<<"free";
-                            return true;
-                        }
-                    //} else {
-                    //}
+                AllocatorNames fromFile;
+                yaml::Input yin((*buffer)->getBuffer());
+                yin>>fromFile;
+                if(yin.error()) {
+                    error = yin.error().message();
+                    return false;
                 }
-            //}
-            return false;
-        }
-
-        bool identifyCopyInstruction(Instruction &I) {
-            if(isa<LoadInst>(&I)) {
-                //errs()<<"\nload..";
-                //I.dump();
-                if(!isa<GetElementPtrInst>(I.getOperand(0)) && isa<PointerType>(I.getType())) {
-                    //errs()<<"\n Load correctly identified \n";
-                    //I.dump();
-                    return true;
+                names.allocators.insert(names.allocators.end(), fromFile.allocators.begin(), fromFile.allocators.end());
+                names.deallocators.insert(names.deallocators.end(), fromFile.deallocators.begin(), fromFile.deallocators.end());
+                names.wrappers.insert(names.wrappers.end(), fromFile.wrappers.begin(), fromFile.wrappers.end());
+            }
+            names.allocators.insert(names.allocators.end(), HOFGAllocators.begin(), HOFGAllocators.end());
+            names.deallocators.insert(names.deallocators.end(), HOFGDeallocators.begin(), HOFGDeallocators.end());
+            names.wrappers.insert(names.wrappers.end(), HOFGAllocatorWrappers.begin(), HOFGAllocatorWrappers.end());
+            StringMap<uint8_t> byName;
+            std::string &text = Callees.names;
+            text.clear();
+            auto add = [&](std::vector<std::string> &list, uint8_t flag, char tag) {
+                std::sort(list.begin(), list.end());
+                for(const std::string &name : list) {
+                    byName[name] |= flag;
+                    text += tag;
+                    text += name;
+                    text += ' ';
                 }
-                return false;
-            } else if (isa<BitCastInst>(&I)) {
-                if(isa<PointerType>(I.getOperand(0)->getType())) {                    
-                    //errs()<<" \n copy via bitcast : ";
-                    //I.dump();
-                    //return true;
+            };
+            add(names.allocators, allocatorCallee, 'a');
+            add(names.deallocators, deallocatorCallee, 'd');
+            add(names.wrappers, wrapperCallee, 'w');
+            Callees.flags.clear();
+            for(Function &F : M) {
+                uint8_t flags = F.isDeclaration() ? 0 : definedCallee;
+                auto it = byName.find(F.getName());
+                if(it != byName.end()) {
+                    flags |= it->second;
                 }
-            }
-            return false;
-        }
-        bool identifyBitCastCopy(Instruction &I) {
-            if(isa<BitCastInst>(I)) {
-                if(isa<GetElementPtrInst>(I.getOperand(0))&&isa<PointerType>(I.getOperand(0)->getType())) {   
-                    return true;
+                if(flags) {
+                    Callees.flags[&F] = flags;
                 }
             }
-            return false;
+            return true;
         }
-        bool identifyLoadInstruction(Instruction &I) {
-            return false;
+        uint8_t calleeFlags(const Function *F) const {
+            return F ? Callees.flags.lookup(F) : 0;
         }
-
-        bool identifyStoreInstruction(Instruction &I) {
-            if(dyn_cast<StoreInst>(&I)){
-                if(isa<PointerType>(I.getOperand(0)->getType())) {
-                    return true;
-                }
-            }
-            return false;
+        uint8_t calleeFlags(Instruction &I) const { //flags of the function I calls directly, 0 if I is no such call
+            CallInst *call = dyn_cast<CallInst>(&I);
+            return call ? calleeFlags(call->getCalledFunction()) : 0;
         }
-
-        bool identifyDeallocation(Instruction &I) {
-            //if(isa<LoadInst>(&I)) {
-            //    LoadInst *Ins = dyn_cast<LoadInst>(&I);
-            //    if(isa<PointerType>(Ins->getOperand(0)->getType()) && !isa<GetElementPtrInst>(Ins->getOperand(0))) {
-            //        return true;
-            //    }
-            //}
-            return false;
+        bool isMallocFunction(Instruction &I) {
+            return calleeFlags(I) & (allocatorCallee | wrapperCallee);
         }
-        bool identifyReturn(Instruction &I) {
-            if(isa<ReturnInst>(&I)){
-                if(I.getNumOperands() < 1) {
-                } else {
-                    return true;
-                }
-                return false;
-            }
-            return false;
+        bool isFreeFunction(Instruction &I) {
+            return calleeFlags(I) & deallocatorCallee;
         }
 
-        bool identifyBitCast(Instruction &I) {
-            if(isa<BitCastInst>(&I)) {
-                if(isa<PointerType>(I.getOperand(0)->getType())) { 
-                    return true;
-                }
-            }
-            return false;
-        }
         /*
         Function : annotateEdge (F flowEdge)
         Input : the flow edge of the HOFG
@@ -1317,49 +2438,29 @@ namespace {
             //local to global
             //local to local
             tail = I.getParent();
-            predBB fromBB;
-            fromBB.bb = tail;
-            if(allBBs.find(fromBB) != allBBs.end()) {
-                fromBB = *(allBBs.find(fromBB));
-                for (Value *c : fromBB.entriConditions) {
-                    flowEdge.conditions.insert(c);
-                }
-            }
+            flowEdge.conditions = Conditions.unite(flowEdge.conditions, guardOf(tail));
         }
-        /*
-        Function : handleRelevantCodeSegment (int Option, BasicBlock &B, Instruction &I)
-        Input : identification of code segment, basic block and instruciton pointer
-        Output : Invoke corresponding function that adds the vertices and edges to HOFG.
-        */
-        void handleRelevantCodeSegment(int option, BasicBlock &B, Instruction &I) { //case handler of code segments that are relevent to algorithm
+        void runHandler(const HandlerStep &step) {
+            size_t vertices = HeapOFGraph.vertices.size(), flows = HeapOFGraph.flows.size();
+            (this->*step.handler)(*step.I->getParent(), *step.I);
+            countHandlerGrowth(step.option, HeapOFGraph.vertices.size() - vertices, HeapOFGraph.flows.size() - flows);
+        }
+        static void countHandlerGrowth(int option, size_t vertices, size_t flows) { //What one handler added, for the statistics
+            TrackingStatistic *addedVertices, *addedFlows;
             switch (option) {
-                case MEM_ALLOC: //errs()<<"\nfound malloc";
-                                addMalloc(B,I); //implemented
-                                break;
-                case MEM_DEALLOC : //errs()<<"\nfound dealloc";
-                                addDealloc(B,I); //implemented
-                                break;
-                case K_COPY : //errs()<<"copy into a known pointer";
-                                addCopy(B,I); //implemented
-                                break;
-                case DEREF : //errs()<<"\n found a dereference";
-                                addDereference(B,I);
-                                break;
-                case STORE : //errs()<<"\nstore instruction";
-                                addStoreToDereference(B,I); //implemented
-                                break;
-                case PHI_COPY : addPhiInstruction(B,I); //implemented
-                                break;
-                case FUNC_CALL :applyFunctionSummary(B,I); //Ongoing
-                                break;
-                case RET :      addReturn(B,I);
-                                break;
-                case BIT_CAST : addCopy(B,I);
-                                break;
-                case GEP_BIT : addGepToBitcast(B,I);
-                                break;
-                default : errs()<<"\ninvalid instruction"<<option;
+                case MEM_ALLOC : addedVertices = &NumMallocVertices; addedFlows = &NumMallocFlows; break;
+                case MEM_DEALLOC : addedVertices = &NumDeallocVertices; addedFlows = &NumDeallocFlows; break;
+                case K_COPY :
+                case BIT_CAST : addedVertices = &NumCopyVertices; addedFlows = &NumCopyFlows; break;
+                case STORE : addedVertices = &NumStoreVertices; addedFlows = &NumStoreFlows; break;
+                case PHI_COPY : addedVertices = &NumPhiVertices; addedFlows = &NumPhiFlows; break;
+                case FUNC_CALL : addedVertices = &NumSummaryVertices; addedFlows = &NumSummaryFlows; break;
+                case RET : addedVertices = &NumReturnVertices; addedFlows = &NumReturnFlows; break;
+                case GEP_BIT : addedVertices = &NumGepVertices; addedFlows = &NumGepFlows; break;
+                default : return;
             }
+            *addedVertices += vertices;
+            *addedFlows += flows;
         }
         void addMalloc(BasicBlock &B, Instruction &I) {
             V objNode,ptrNode;
@@ -1371,183 +2472,155 @@ namespace {
             } else {
                 //errs()<<"\n did not detect void\n";
             }
-            for(BasicBlock::iterator BI=B.begin(); BI!=B.end(); BI++) {
-                Instruction &Ins(*BI);
-                if(Ins.getNumOperands()<1) {
-                    continue;
+            HeapOFGraph.insertVertex(objNode); //malloc function is called, used or not
+            //Users of the allocation in this block, taking it as first operand, visited in block order
+            SmallVector<Instruction*,4> blockUsers;
+            for(User *U : I.users()) {
+                Instruction *UI = dyn_cast<Instruction>(U);
+                if(UI && UI->getParent() == &B && UI->getOperand(0) == &I) {
+                    blockUsers.push_back(UI);
                 }
-                if(dyn_cast<Instruction>(Ins.getOperand(0)) == &I) {
-                    F flowEdge;
-                    if(isa<BitCastInst>(Ins)) {//for two level pointers, there can be load statement instead of bitcast befor malloc
-                        ptrNode.name=dyn_cast<Value>(&Ins);
-                        ptrNode.vertexTy=ptr;
-                        HeapOFGraph.vertices.insert(objNode);
-                        HeapOFGraph.vertices.insert(ptrNode);
-                        objNode=*(HeapOFGraph.vertices.find(objNode));
-                        ptrNode=*(HeapOFGraph.vertices.find(ptrNode));
-                        flowEdge.head=ptrNode;
-                        flowEdge.tail=objNode;
-                        annotateEdge(flowEdge,I);
-                        if(HeapOFGraph.flows.find(flowEdge) != HeapOFGraph.flows.end()) {
-                        //    errs()<<"\nRepeat can be detected here";
-                        } else if (isa<Argument>(ptrNode.name)) {
-                            for(Argument &A : I.getFunction()->args()) {
-                                Value* arg = dyn_cast<Value>(&A);
-                                if(arg == ptrNode.name) {
-                                    FuncSummary summary;
-                                    summary.funcName = I.getFunction();
-                                    if(allFuncSummaries.find(summary)!=allFuncSummaries.end()) {
-                                        fsit = allFuncSummaries.find(summary);
-                                        annotateEdge(flowEdge,I);
-                                        flowEdge.location=I.getDebugLoc();
-                                        //errs()<<"Line number 1 "<<I.getDebugLoc().getLine();
-                                        if(HeapOFGraph.flows.insert(flowEdge).second) {
-                                            //annotateEdge(flowEdge,I);
-                                            errs()<<"\n allocated from here";
-                                            argTransformIt = fsit->argTransforms.begin();
-                                            advance(argTransformIt,(dyn_cast<Argument>(arg))->getArgNo());
-                                            fsit->argTransforms.insert(argTransformIt,allocator);
-                                            argTransform newTF;
-                                            newTF.typeOfTransform=allocator;
-                                            newTF.argumentNumber=(dyn_cast<Argument>(arg))->getArgNo();
-                                            fsit->argumentTransform.insert(newTF);
-                                        }
-                                    }
+            }
+            std::sort(blockUsers.begin(), blockUsers.end(), [](Instruction *a, Instruction *b) {return a->comesBefore(b);});
+            blockUsers.erase(std::unique(blockUsers.begin(), blockUsers.end()), blockUsers.end());
+            for(Instruction *UI : blockUsers) {
+                Instruction &Ins(*UI);
+                F flowEdge;
+                if(isa<BitCastInst>(Ins)) {//for two level pointers, there can be load statement instead of bitcast befor malloc
+                    ptrNode.name=dyn_cast<Value>(&Ins);
+                    ptrNode.vertexTy=ptr;
+                    HeapOFGraph.insertVertex(objNode);
+                    HeapOFGraph.insertVertex(ptrNode);
+                    objNode=HeapOFGraph.getVertex(objNode.name);
+                    ptrNode=HeapOFGraph.getVertex(ptrNode.name);
+                    flowEdge.head=ptrNode;
+                    flowEdge.tail=objNode;
+                    annotateEdge(flowEdge,I);
+                    if(HeapOFGraph.hasFlow(flowEdge)) {
+                    //    errs()<<"\nRepeat can be detected here";
+                    } else if (isa<Argument>(ptrNode.name)) {
+                        for(Argument &A : I.getFunction()->args()) {
+                            Value* arg = dyn_cast<Value>(&A);
+                            if(arg == ptrNode.name) {
+                                if(FuncSummary *fsit = summaryOf(I.getFunction())) {
                                     annotateEdge(flowEdge,I);
-                                    flowEdge.location=I.getDebugLoc();
-                                    HeapOFGraph.flows.insert(flowEdge);
-                                    break;
+                                    flowEdge.location=Locations.intern(I.getDebugLoc());
+                                    //errs()<<"Line number 1 "<<I.getDebugLoc().getLine();
+                                    if(HeapOFGraph.insertFlow(flowEdge)) {
+                                        //annotateEdge(flowEdge,I);
+                                        fsit->addArgTransform(dyn_cast<Argument>(arg)->getArgNo(), allocator);
+                                    }
                                 }
-                            }            
-                        } else if(isa<Argument>(Ins.getOperand(0))) {
+                                annotateEdge(flowEdge,I);
+                                flowEdge.location=Locations.intern(I.getDebugLoc());
+                                HeapOFGraph.insertFlow(flowEdge);
+                                break;
+                            }
+                        }            
+                    } else if(isa<Argument>(Ins.getOperand(0))) {
 
-                        } else {
-                                //}
+                    } else {
                             //}
-                            annotateEdge(flowEdge,I);
-                            flowEdge.location=I.getDebugLoc();
-                            //errs()<<"Line number 2"<<I.getDebugLoc().getLine();
-                            HeapOFGraph.flows.insert(flowEdge);
-                        //errs()<<"\n Adding flow edge while handling malloc : \n";
-                        //I.dump();
-                        //errs()<<"\n to \n";
-                        //Ins.dump();
-                        //errs()<<"...................";
-                        }
-                    } else if (isa<LoadInst>(Ins)) {
-                        //To be handled for two level pointers
-                    } else if (isa<StoreInst>(Ins)) {
-                        ptrNode.vertexTy=ptr;
-                        ptrNode.name=dyn_cast<Value>(Ins.getOperand(1));
-                        HeapOFGraph.vertices.insert(objNode);
-                        HeapOFGraph.vertices.insert(ptrNode);
-                        objNode=*(HeapOFGraph.vertices.find(objNode));
-                        ptrNode=*(HeapOFGraph.vertices.find(ptrNode));
-                        flowEdge.head=ptrNode;
-                        flowEdge.tail=objNode;
-                        
-                        if(HeapOFGraph.vertices.find(ptrNode) != HeapOFGraph.vertices.end()) {
-                            if (isa<BitCastInst>(Ins.getOperand(1))) {
-                                BitCastInst *bitc = dyn_cast<BitCastInst>(Ins.getOperand(1));
-                                if(isa<Argument>(bitc->getOperand(0))) {
-                                    
-                                    for(Argument &A : I.getFunction()->args()) {
-                                        Value *arg = dyn_cast<Value>(&A);
-                                        if(arg == bitc->getOperand(0)) {
-                                            //errs()<<"\n........";
-                                            //bitc->dump();
-                                            //arg->dump();
-                                            V argNode;
-                                            std::set<V>::iterator vertit;
-                                            argNode.name=arg;
-                                            argNode.vertexTy=ptr;
-                                            if(HeapOFGraph.vertices.find(argNode) != HeapOFGraph.vertices.end()) {
-                                                vertit = HeapOFGraph.vertices.find(argNode);
-                                                argNode=*(HeapOFGraph.vertices.find(argNode));
-                                            } else {
-                                                HeapOFGraph.vertices.insert(argNode);
-                                                vertit = HeapOFGraph.vertices.find(argNode);
-                                                argNode=*(HeapOFGraph.vertices.find(argNode));
-                                            }
-                                            F argFlowEdge;
-                                            argFlowEdge.head=argNode;
-                                            argFlowEdge.tail=ptrNode;
-                                            annotateEdge(argFlowEdge,I);//Annotate should be double checked
-                                            argFlowEdge.location = I.getDebugLoc();
-                                            if(HeapOFGraph.flows.find(argFlowEdge) != HeapOFGraph.flows.end()) {
-                                            } else {
-                                                FuncSummary summary;
-                                                summary.funcName = I.getFunction();
-                                                std::set<FuncSummary>::iterator fsitloc;
-                                                if(allFuncSummaries.find(summary)!=allFuncSummaries.end()) {
-                                                    fsitloc = allFuncSummaries.find(summary);
-                                                    argTransformIt = fsitloc->argTransforms.begin();
-                                                    advance(argTransformIt,(dyn_cast<Argument>(arg))->getArgNo());
-                                                    if(fsitloc->argTransforms.size() > 0 && *(argTransformIt) == allocator) {
-                                                        //  errs()<<"\n detected allocator in arg transforms of length:"<<fsitloc->argTransforms.size();
-                                                    } else {
-                                                    fsitloc->functionType=allocator;
-                                                    //errs()<<";;;;;;;;;;;;;;;;;;;;;;";
-                                                    //I.dump();
-                                                    //errs()<<"\nallocated from here for arg number"<<(dyn_cast<Argument>(arg))->getArgNo();
-                                                    //errs()<<"\n For function : "<<fsitloc->funcName->getName()<<"\n";
-                                                    fsitloc->argTransforms.insert(argTransformIt,allocator);
-                                                    
-                                                    }
-                                                    //if(fsitloc->argumentTransform.insert(newTF).second) {
-                                                    //    errs()<<"\n it is successfully inserted, but why?????????????????????????????";
-                                                    //}
-                                                    argTransform newTF;
-                                                    newTF.typeOfTransform=allocator;
-                                                    newTF.argumentNumber=(dyn_cast<Argument>(arg))->getArgNo();
-                                                    fsitloc->argumentTransform.insert(newTF);
-                                                }
+                        //}
+                        annotateEdge(flowEdge,I);
+                        flowEdge.location=Locations.intern(I.getDebugLoc());
+                        //errs()<<"Line number 2"<<I.getDebugLoc().getLine();
+                        HeapOFGraph.insertFlow(flowEdge);
+                    //errs()<<"\n Adding flow edge while handling malloc : \n";
+                    //I.dump();
+                    //errs()<<"\n to \n";
+                    //Ins.dump();
+                    //errs()<<"...................";
+                    }
+                } else if (isa<LoadInst>(Ins)) {
+                    //To be handled for two level pointers
+                } else if (isa<StoreInst>(Ins)) {
+                    ptrNode.vertexTy=ptr;
+                    ptrNode.name=dyn_cast<Value>(Ins.getOperand(1));
+                    HeapOFGraph.insertVertex(objNode);
+                    HeapOFGraph.insertVertex(ptrNode);
+                    objNode=HeapOFGraph.getVertex(objNode.name);
+                    ptrNode=HeapOFGraph.getVertex(ptrNode.name);
+                    flowEdge.head=ptrNode;
+                    flowEdge.tail=objNode;
+                    
+                    if(HeapOFGraph.hasVertex(ptrNode.name)) {
+                        if (isa<BitCastInst>(Ins.getOperand(1))) {
+                            BitCastInst *bitc = dyn_cast<BitCastInst>(Ins.getOperand(1));
+                            if(isa<Argument>(bitc->getOperand(0))) {
+                                
+                                for(Argument &A : I.getFunction()->args()) {
+                                    Value *arg = dyn_cast<Value>(&A);
+                                    if(arg == bitc->getOperand(0)) {
+                                        //errs()<<"\n........";
+                                        //bitc->dump();
+                                        //arg->dump();
+                                        V argNode;
+                                        argNode.name=arg;
+                                        argNode.vertexTy=ptr;
+                                        if(HeapOFGraph.hasVertex(argNode.name)) {
+                                            argNode=HeapOFGraph.getVertex(argNode.name);
+                                        } else {
+                                            HeapOFGraph.insertVertex(argNode);
+                                            argNode=HeapOFGraph.getVertex(argNode.name);
+                                        }
+                                        F argFlowEdge;
+                                        argFlowEdge.head=argNode;
+                                        argFlowEdge.tail=ptrNode;
+                                        annotateEdge(argFlowEdge,I);//Annotate should be double checked
+                                        argFlowEdge.location = Locations.intern(I.getDebugLoc());
+                                        if(HeapOFGraph.hasFlow(argFlowEdge)) {
+                                        } else {
+                                            if(FuncSummary *fsitloc = summaryOf(I.getFunction())) {
+                                                if(fsitloc->argTransforms[dyn_cast<Argument>(arg)->getArgNo()] & allocatesArg) {
+                                                    //  errs()<<"\n detected allocator in arg transforms of length:"<<fsitloc->argTransforms.size();
+                                                } else {
+                                                fsitloc->functionType=allocator;
+                                                //errs()<<";;;;;;;;;;;;;;;;;;;;;;";
+                                                //I.dump();
+                                                //errs()<<"\nallocated from here for arg number"<<(dyn_cast<Argument>(arg))->getArgNo();
+                                                //errs()<<"\n For function : "<<fsitloc->funcName->getName()<<"\n";
                                                 
-                                                //errs()<<"Line number 3 "<<bitc->getDebugLoc().getLine();
-                                                if(HeapOFGraph.flows.insert(argFlowEdge).second) {
-                                                    
                                                 }
+                                                //if(fsitloc->argumentTransform.insert(newTF).second) {
+                                                //    errs()<<"\n it is successfully inserted, but why?????????????????????????????";
+                                                //}
+                                                fsitloc->addArgTransform(dyn_cast<Argument>(arg)->getArgNo(), allocator);
+                                            }
+                                            
+                                            //errs()<<"Line number 3 "<<bitc->getDebugLoc().getLine();
+                                            if(HeapOFGraph.insertFlow(argFlowEdge)) {
+                                                
                                             }
                                         }
                                     }
                                 }
                             }
-                            if (isa<Argument>(ptrNode.name)) {
-                                for(Argument &A : I.getFunction()->args()) {
-                                Value* arg = dyn_cast<Value>(&A);
-                                if(arg == ptrNode.name) {
-                                    FuncSummary summary;
-                                    summary.funcName = I.getFunction();
-                                    if(allFuncSummaries.find(summary)!=allFuncSummaries.end()) {
-                                        fsit = allFuncSummaries.find(summary);
-                                        annotateEdge(flowEdge,I);
-                                        flowEdge.location=I.getDebugLoc();
-                                        //errs()<<"Line number 4 "<<I.getDebugLoc().getLine();
-                                        if(HeapOFGraph.flows.insert(flowEdge).second) {
-                                            argTransformIt = fsit->argTransforms.begin();
-                                            advance(argTransformIt,(dyn_cast<Argument>(arg))->getArgNo());
-                                            fsit->argTransforms.insert(argTransformIt,allocator);
-                                        }
-                                        argTransform newTF;
-                                        newTF.typeOfTransform=allocator;
-                                        newTF.argumentNumber=(dyn_cast<Argument>(arg))->getArgNo();
-                                        fsit->argumentTransform.insert(newTF);
-                                    }
+                        }
+                        if (isa<Argument>(ptrNode.name)) {
+                            for(Argument &A : I.getFunction()->args()) {
+                            Value* arg = dyn_cast<Value>(&A);
+                            if(arg == ptrNode.name) {
+                                if(FuncSummary *fsit = summaryOf(I.getFunction())) {
                                     annotateEdge(flowEdge,I);
-                                    flowEdge.location=I.getDebugLoc();
-                                    //errs()<<"Line number 5 "<<I.getDebugLoc().getLine();
-                                    HeapOFGraph.flows.insert(flowEdge);
-                                    break;
+                                    flowEdge.location=Locations.intern(I.getDebugLoc());
+                                    //errs()<<"Line number 4 "<<I.getDebugLoc().getLine();
+                                    if(HeapOFGraph.insertFlow(flowEdge)) {
+                                    }
+                                    fsit->addArgTransform(dyn_cast<Argument>(arg)->getArgNo(), allocator);
                                 }
-                                } 
-                            
+                                annotateEdge(flowEdge,I);
+                                flowEdge.location=Locations.intern(I.getDebugLoc());
+                                //errs()<<"Line number 5 "<<I.getDebugLoc().getLine();
+                                HeapOFGraph.insertFlow(flowEdge);
+                                break;
                             }
+                            } 
+                        
                         }
-                    } else if(isa<ReturnInst>(Ins)) {
-                        //edge added in return instruction handler
                     }
-                } else {
-                    HeapOFGraph.vertices.insert(objNode); //malloc funciton is called, but not used
+                } else if(isa<ReturnInst>(Ins)) {
+                    //edge added in return instruction handler
                 }
             }
         }
@@ -1555,9 +2628,8 @@ namespace {
             V freeNode,ptrNode;
             freeNode.name=dyn_cast<Value>(&I);
             freeNode.vertexTy=snk;
-            if (HeapOFGraph.vertices.find(freeNode) != HeapOFGraph.vertices.end()) {
-                vit=HeapOFGraph.vertices.find(freeNode);
-                freeNode = *vit;
+            if (HeapOFGraph.knowsVertex(freeNode.name)) { //the sink of this call itself, so not a missed lookup
+                freeNode = HeapOFGraph.getVertex(freeNode.name);
             } else {
             }
             if (isa<Argument>(I.getOperand(0))) {
@@ -1565,32 +2637,19 @@ namespace {
                     Value* arg = dyn_cast<Value>(&A);
                     if(arg == I.getOperand(0)) {
                         ptrNode.name=dyn_cast<Value>(I.getOperand(0));
-                        if (HeapOFGraph.vertices.find(ptrNode) != HeapOFGraph.vertices.end()) {
-                            ptrNode=*(HeapOFGraph.vertices.find(ptrNode));
+                        if (HeapOFGraph.hasVertex(ptrNode.name)) {
+                            ptrNode=HeapOFGraph.getVertex(ptrNode.name);
                             F flowEdge;
                             flowEdge.tail=ptrNode;
                             flowEdge.head=freeNode;
-                            HeapOFGraph.vertices.insert(freeNode);
-                            freeNode=*(HeapOFGraph.vertices.find(freeNode));
+                            HeapOFGraph.insertVertex(freeNode);
+                            freeNode=HeapOFGraph.getVertex(freeNode.name);
                             annotateEdge(flowEdge,I);
-                            flowEdge.location=I.getDebugLoc();
+                            flowEdge.location=Locations.intern(I.getDebugLoc());
                             //errs()<<"Line number 6 "<<I.getDebugLoc().getLine();
-                            if(HeapOFGraph.flows.insert(flowEdge).second) {
-                                FuncSummary summary;
-                                summary.funcName = I.getFunction();
-                                if(allFuncSummaries.find(summary)!=allFuncSummaries.end()) {
-                                    fsit = allFuncSummaries.find(summary);
-                                    argTransformIt = fsit->argTransforms.begin();
-                                    advance(argTransformIt,(dyn_cast<Argument>(arg))->getArgNo());
-                                    if(*argTransformIt == deallocator) {
-
-                                    } else {
-                                        fsit->argTransforms.insert(argTransformIt,deallocator);
-                                    }
-                                    argTransform newTF;
-                                    newTF.typeOfTransform=deallocator;
-                                    newTF.argumentNumber=(dyn_cast<Argument>(arg))->getArgNo();
-                                    fsit->argumentTransform.insert(newTF);                            
+                            if(HeapOFGraph.insertFlow(flowEdge)) {
+                                if(FuncSummary *fsit = summaryOf(I.getFunction())) {
+                                    fsit->addArgTransform(dyn_cast<Argument>(arg)->getArgNo(), deallocator);
                                 }
                             }
                         }
@@ -1598,346 +2657,280 @@ namespace {
                     }
                 }
             }
-            Function *Func = I.getFunction();
-            for(Function::iterator FI=Func->begin(); FI!=Func->end();FI++) {
-                BasicBlock &BB(*FI);
-            
-            for(BasicBlock::iterator BI=BB.begin(); BI!=BB.end(); BI++) {
-                Instruction &Ins(*BI);
-                if(dyn_cast<Instruction>(I.getOperand(0)) == &Ins) {
-                    if(isa<BitCastInst>(Ins) && isa<LoadInst>(Ins.getOperand(0))) {
-                        LoadInst *load = dyn_cast<LoadInst>(Ins.getOperand(0));
-                        if(isa<PointerType>(load->getType())) {
-                            if(GetElementPtrInst *gep = dyn_cast<GetElementPtrInst>(load->getOperand(0))) {
-                                if(isa<Argument>(gep->getOperand(0))){
-                                for(Argument &A : I.getFunction()->args()) {
-                                        Value* arg = dyn_cast<Value>(&A);
-                                        if(arg == gep->getOperand(0)) {
-                                            std::set<V>::iterator vertit;
-                                            freeNode.name=dyn_cast<Value>(&I);
-                                            freeNode.vertexTy=snk;
-                                            if(HeapOFGraph.vertices.find(freeNode) != HeapOFGraph.vertices.end()) {
-                                                vertit=HeapOFGraph.vertices.find(freeNode);
-                                                freeNode=*(HeapOFGraph.vertices.find(freeNode));
-                                            } else {
-                                                if(HeapOFGraph.vertices.insert(freeNode).second) {
-                                                    vertit=HeapOFGraph.vertices.find(freeNode);
-                                                    freeNode=*(HeapOFGraph.vertices.find(freeNode));
-                                                }
+            //The definition of free's operand is reached through its def-use link instead of scanning the function
+            if(Instruction *operandDef = dyn_cast<Instruction>(I.getOperand(0))) {
+                Instruction &Ins(*operandDef);
+                if(isa<BitCastInst>(Ins) && isa<LoadInst>(Ins.getOperand(0))) {
+                    LoadInst *load = dyn_cast<LoadInst>(Ins.getOperand(0));
+                    if(isa<PointerType>(load->getType())) {
+                        if(GetElementPtrInst *gep = dyn_cast<GetElementPtrInst>(load->getOperand(0))) {
+                            if(isa<Argument>(gep->getOperand(0))){
+                            for(Argument &A : I.getFunction()->args()) {
+                                    Value* arg = dyn_cast<Value>(&A);
+                                    if(arg == gep->getOperand(0)) {
+                                        freeNode.name=dyn_cast<Value>(&I);
+                                        freeNode.vertexTy=snk;
+                                        if(HeapOFGraph.hasVertex(freeNode.name)) {
+                                            freeNode=HeapOFGraph.getVertex(freeNode.name);
+                                        } else {
+                                            if(HeapOFGraph.insertVertex(freeNode)) {
+                                                freeNode=HeapOFGraph.getVertex(freeNode.name);
                                             }
-                                            ptrNode.name = gep->getOperand(0);
-                                            ptrNode.vertexTy = ptr;
-                                            if(HeapOFGraph.vertices.find(ptrNode) != HeapOFGraph.vertices.end()) {
-                                               
-                                            } else {
-                                                if(HeapOFGraph.vertices.insert(ptrNode).second) {
-                                                    ptrNode=*(HeapOFGraph.vertices.find(ptrNode));
-                                                }
+                                        }
+                                        ptrNode.name = gep->getOperand(0);
+                                        ptrNode.vertexTy = ptr;
+                                        if(HeapOFGraph.hasVertex(ptrNode.name)) {
+                                           
+                                        } else {
+                                            if(HeapOFGraph.insertVertex(ptrNode)) {
+                                                ptrNode=HeapOFGraph.getVertex(ptrNode.name);
                                             }
-                                            F flowEdge;
-                                            flowEdge.tail=ptrNode;
-                                            flowEdge.head=freeNode;
-                                            annotateEdge(flowEdge,I);
-                                            flowEdge.location=I.getDebugLoc();
-                                            if(HeapOFGraph.flows.find(flowEdge) != HeapOFGraph.flows.end()) {
-                                            } else {
-                                                //errs()<<"Line number 7 "<<I.getDebugLoc().getLine();
-                                                if(HeapOFGraph.flows.insert(flowEdge).second){
-                                                    FuncSummary summary;
-                                                    summary.funcName = I.getFunction();
-                                                    if(allFuncSummaries.find(summary)!=allFuncSummaries.end()) {
-                                                        std::set<FuncSummary>::iterator fsitl;
-                                                        std::list<funcType>::iterator argTransformItl;
-                                                        fsitl = allFuncSummaries.find(summary);
-                                                        argTransformItl = fsitl->argTransforms.begin();
-                                                        if(find(fsitl->argTransforms.begin(),fsitl->argTransforms.end(),deallocator) != fsitl->argTransforms.end()) {
-                                                            fsitl->functionType=deallocator;
-                                                        } else {
-                                                            fsitl->argTransforms.insert(argTransformItl,deallocator);
-                                                        }
-                                                        argTransform newTF;
-                                                        newTF.typeOfTransform=deallocator;
-                                                        newTF.argumentNumber=(dyn_cast<Argument>(arg))->getArgNo();
-                                                        fsitl->argumentTransform.insert(newTF);
+                                        }
+                                        F flowEdge;
+                                        flowEdge.tail=ptrNode;
+                                        flowEdge.head=freeNode;
+                                        annotateEdge(flowEdge,I);
+                                        flowEdge.location=Locations.intern(I.getDebugLoc());
+                                        if(HeapOFGraph.hasFlow(flowEdge)) {
+                                        } else {
+                                            //errs()<<"Line number 7 "<<I.getDebugLoc().getLine();
+                                            if(HeapOFGraph.insertFlow(flowEdge)){
+                                                if(FuncSummary *fsitl = summaryOf(I.getFunction())) {
+                                                    if(fsitl->allTransforms() & deallocatesArg) {
                                                         fsitl->functionType=deallocator;
                                                     }
+                                                    fsitl->addArgTransform(dyn_cast<Argument>(arg)->getArgNo(), deallocator);
+                                                    fsitl->functionType=deallocator;
                                                 }
                                             }
-
                                         }
+
                                     }
                                 }
+                            }
+                        } else {
+                            ptrNode.name=dyn_cast<Value>(&Ins);
+                            ptrNode.vertexTy=ptr;
+                            if (HeapOFGraph.hasVertex(ptrNode.name)) {
+                                ptrNode = HeapOFGraph.getVertex(ptrNode.name);
                             } else {
-                                ptrNode.name=dyn_cast<Value>(&Ins);
-                                ptrNode.vertexTy=ptr;
-                                if (HeapOFGraph.vertices.find(ptrNode) != HeapOFGraph.vertices.end()) {
-                                    vit=HeapOFGraph.vertices.find(ptrNode);
-                                    ptrNode = *vit;
-                                } else {
-                                    if(! HeapOFGraph.vertices.insert(ptrNode).second) {
+                                if(! HeapOFGraph.insertVertex(ptrNode)) {
 
-                                        ptrNode=*(HeapOFGraph.vertices.find(ptrNode));
-                                        //errs()<<"\n now it is totaly wrong";
-                                    } else {
-                                        //errs()<<"\nIt is added freom here";
-                                    }
+                                    ptrNode=HeapOFGraph.getVertex(ptrNode.name);
+                                    //errs()<<"\n now it is totaly wrong";
+                                } else {
+                                    //errs()<<"\nIt is added freom here";
                                 }
-                                F flowEdge;
-                                flowEdge.tail=ptrNode;
-                                flowEdge.head=freeNode;
+                            }
+                            F flowEdge;
+                            flowEdge.tail=ptrNode;
+                            flowEdge.head=freeNode;
+                            annotateEdge(flowEdge,I);
+                            if(HeapOFGraph.hasFlow(flowEdge)) {
+                            } else {
+                                HeapOFGraph.insertVertex(freeNode);
+                                freeNode=HeapOFGraph.getVertex(freeNode.name);
                                 annotateEdge(flowEdge,I);
-                                if(HeapOFGraph.flows.find(flowEdge) != HeapOFGraph.flows.end()) {
-                                } else {
-                                    HeapOFGraph.vertices.insert(freeNode);
-                                    freeNode=*(HeapOFGraph.vertices.find(freeNode));
-                                    annotateEdge(flowEdge,I);
-                                    flowEdge.location=I.getDebugLoc();
-                                    //errs()<<"Line number 9 "<<I.getDebugLoc().getLine();
-                                    if(HeapOFGraph.flows.insert(flowEdge).second){
-                                        if(isa<Argument>(ptrNode.name)){ 
-                                            for(Argument &A : I.getFunction()->args()) {
-                                                Value* arg = dyn_cast<Value>(&A);
-                                                if(arg == ptrNode.name || arg == dyn_cast<Instruction>(ptrNode.name)->getOperand(0)) {
-                                                    Argument *arg = dyn_cast<Argument>(ptrNode.name);
-                                                    FuncSummary summary;
-                                                    summary.funcName = I.getFunction();
-                                                    if(allFuncSummaries.find(summary)!=allFuncSummaries.end()) {
-                                                        fsit = allFuncSummaries.find(summary);
-                                                        argTransformIt = fsit->argTransforms.begin();
-                                                        advance(argTransformIt,(dyn_cast<Argument>(arg))->getArgNo());
-                                                         fsit->argTransforms.insert(argTransformIt,deallocator);
-                                                         argTransform newTF;
-                                                        newTF.typeOfTransform=deallocator;
-                                                        newTF.argumentNumber=(dyn_cast<Argument>(arg))->getArgNo();
-                                                        fsit->argumentTransform.insert(newTF);
-                                                    }
-
-                                                    break;
+                                flowEdge.location=Locations.intern(I.getDebugLoc());
+                                //errs()<<"Line number 9 "<<I.getDebugLoc().getLine();
+                                if(HeapOFGraph.insertFlow(flowEdge)){
+                                    if(isa<Argument>(ptrNode.name)){ 
+                                        for(Argument &A : I.getFunction()->args()) {
+                                            Value* arg = dyn_cast<Value>(&A);
+                                            if(arg == ptrNode.name || arg == dyn_cast<Instruction>(ptrNode.name)->getOperand(0)) {
+                                                Argument *arg = dyn_cast<Argument>(ptrNode.name);
+                                                if(FuncSummary *fsit = summaryOf(I.getFunction())) {
+                                                     fsit->addArgTransform(dyn_cast<Argument>(arg)->getArgNo(), deallocator);
                                                 }
+
+                                                break;
                                             }
-                                        } else if(isa<GlobalVariable>(ptrNode.name)) {
-                                            //This is a deallocation of a global variable
-                                            FuncSummary summary;
-                                            summary.funcName = I.getFunction();
-                                            if(allFuncSummaries.find(summary)!=allFuncSummaries.end()) {
-                                                fsit = allFuncSummaries.find(summary);
-                                                fsit->globalDealloc.insert(freeNode.name);
-                                            }
-                                        } else if(isa<GlobalVariable>(dyn_cast<Instruction>(ptrNode.name)->getOperand(0))) {
-                                            FuncSummary summary;
-                                            summary.funcName = I.getFunction();
-                                            if(allFuncSummaries.find(summary)!=allFuncSummaries.end()) {
-                                                fsit = allFuncSummaries.find(summary);
-                                                Value *v=dyn_cast<Value>(dyn_cast<Instruction>(freeNode.name)->getOperand(0));
-                                                fsit->globalDealloc.insert(v);
-                                            }
+                                        }
+                                    } else if(isa<GlobalVariable>(ptrNode.name)) {
+                                        //This is a deallocation of a global variable
+                                        if(FuncSummary *fsit = summaryOf(I.getFunction())) {
+                                            FuncSummary::addValue(fsit->globalDealloc, freeNode.name);
+                                        }
+                                    } else if(isa<GlobalVariable>(dyn_cast<Instruction>(ptrNode.name)->getOperand(0))) {
+                                        if(FuncSummary *fsit = summaryOf(I.getFunction())) {
+                                            Value *v=dyn_cast<Value>(dyn_cast<Instruction>(freeNode.name)->getOperand(0));
+                                            FuncSummary::addValue(fsit->globalDealloc, v);
                                         }
                                     }
                                 }
                             }
                         }
-                    } else if(isa<BitCastInst>(Ins) && isa<GetElementPtrInst>(Ins.getOperand(0))) {
-                        GetElementPtrInst *gep = dyn_cast<GetElementPtrInst>(Ins.getOperand(0));
-                        //if(load->getType()) {
-                            if(LoadInst *load = dyn_cast<LoadInst>(gep->getOperand(0))) {
-                                if(isa<Argument>(load->getOperand(0))){ //|| isa<Argument>(dyn_cast<Instruction>(ptrNode.name)->getOperand(0))) {
-                                    for(Argument &A : I.getFunction()->args()) {
-                                        Value* arg = dyn_cast<Value>(&A);
-                                        if(arg == load->getOperand(0)) {
-                                            std::set<V>::iterator vertit;
-                                            freeNode.name=dyn_cast<Value>(&I);
-                                            freeNode.vertexTy=snk;
-                                            if(HeapOFGraph.vertices.find(freeNode) != HeapOFGraph.vertices.end()) {
-                                                
-                                                freeNode=*(HeapOFGraph.vertices.find(freeNode));
-                                                vertit=HeapOFGraph.vertices.find(freeNode);
-                                            } else {
-                                                if(HeapOFGraph.vertices.insert(freeNode).second) {
-                                                    vertit=HeapOFGraph.vertices.find(freeNode);
-                                                    freeNode=*(HeapOFGraph.vertices.find(freeNode));
-                                                }
+                    }
+                } else if(isa<BitCastInst>(Ins) && isa<GetElementPtrInst>(Ins.getOperand(0))) {
+                    GetElementPtrInst *gep = dyn_cast<GetElementPtrInst>(Ins.getOperand(0));
+                    //if(load->getType()) {
+                        if(LoadInst *load = dyn_cast<LoadInst>(gep->getOperand(0))) {
+                            if(isa<Argument>(load->getOperand(0))){ //|| isa<Argument>(dyn_cast<Instruction>(ptrNode.name)->getOperand(0))) {
+                                for(Argument &A : I.getFunction()->args()) {
+                                    Value* arg = dyn_cast<Value>(&A);
+                                    if(arg == load->getOperand(0)) {
+                                        freeNode.name=dyn_cast<Value>(&I);
+                                        freeNode.vertexTy=snk;
+                                        if(HeapOFGraph.hasVertex(freeNode.name)) {
+                                            
+                                            freeNode=HeapOFGraph.getVertex(freeNode.name);
+                                        } else {
+                                            if(HeapOFGraph.insertVertex(freeNode)) {
+                                                freeNode=HeapOFGraph.getVertex(freeNode.name);
                                             }
-                                            ptrNode.name = load->getOperand(0);
-                                            ptrNode.vertexTy = ptr;
-                                            if(HeapOFGraph.vertices.find(ptrNode) != HeapOFGraph.vertices.end()) {
-                                               
-                                                ptrNode=*(HeapOFGraph.vertices.find(ptrNode));
-                                            } else {
-                                                if(HeapOFGraph.vertices.insert(ptrNode).second) {
-                                                    ptrNode=*(HeapOFGraph.vertices.find(ptrNode));   
-                                                }
+                                        }
+                                        ptrNode.name = load->getOperand(0);
+                                        ptrNode.vertexTy = ptr;
+                                        if(HeapOFGraph.hasVertex(ptrNode.name)) {
+                                           
+                                            ptrNode=HeapOFGraph.getVertex(ptrNode.name);
+                                        } else {
+                                            if(HeapOFGraph.insertVertex(ptrNode)) {
+                                                ptrNode=HeapOFGraph.getVertex(ptrNode.name);   
                                             }
-                                            F flowEdge;
-                                            flowEdge.tail=ptrNode;
-                                            flowEdge.head=freeNode;
-                                            annotateEdge(flowEdge,I);
-                                            flowEdge.location=I.getDebugLoc();
-                                            if(HeapOFGraph.flows.find(flowEdge) != HeapOFGraph.flows.end()) {
-                                            } else {
-                                                //errs()<<"Line number 8 "<<I.getDebugLoc().getLine();
-                                                if(HeapOFGraph.flows.insert(flowEdge).second){
-                                                    FuncSummary summary;
-                                                    summary.funcName = I.getFunction();
-                                                    if(allFuncSummaries.find(summary)!=allFuncSummaries.end()) {
-                                                        std::set<FuncSummary>::iterator fsitl;
-                                                        std::list<funcType>::iterator argTransformItl;
-                                                        fsitl = allFuncSummaries.find(summary);
-                                                        argTransformItl = fsitl->argTransforms.begin();
-                                                        if(find(fsitl->argTransforms.begin(),fsitl->argTransforms.end(),deallocator) != fsitl->argTransforms.end()) {
-                                                            fsitl->functionType=deallocator;
-                                                        } else {
-                                                            fsitl->argTransforms.insert(argTransformItl,deallocator);
-                                                        }
-                                                        argTransform newTF;
-                                                        newTF.typeOfTransform=deallocator;
-                                                        newTF.argumentNumber=(dyn_cast<Argument>(arg))->getArgNo();
-                                                        fsitl->argumentTransform.insert(newTF);
+                                        }
+                                        F flowEdge;
+                                        flowEdge.tail=ptrNode;
+                                        flowEdge.head=freeNode;
+                                        annotateEdge(flowEdge,I);
+                                        flowEdge.location=Locations.intern(I.getDebugLoc());
+                                        if(HeapOFGraph.hasFlow(flowEdge)) {
+                                        } else {
+                                            //errs()<<"Line number 8 "<<I.getDebugLoc().getLine();
+                                            if(HeapOFGraph.insertFlow(flowEdge)){
+                                                if(FuncSummary *fsitl = summaryOf(I.getFunction())) {
+                                                    if(fsitl->allTransforms() & deallocatesArg) {
                                                         fsitl->functionType=deallocator;
                                                     }
+                                                    fsitl->addArgTransform(dyn_cast<Argument>(arg)->getArgNo(), deallocator);
+                                                    fsitl->functionType=deallocator;
                                                 }
                                             }
                                         }
                                     }
                                 }
                             }
-                        //}
-                    } else if(isa<BitCastInst>(Ins)) {//for 2 level pointers, there can be load instead of bitcast as operand of free
-                        ptrNode.name=dyn_cast<Value>(&Ins);
-                        ptrNode.vertexTy=ptr;
-                        if (HeapOFGraph.vertices.find(ptrNode) != HeapOFGraph.vertices.end()) {
-                            vit=HeapOFGraph.vertices.find(ptrNode);
-                            ptrNode = *vit;
+                        }
+                    //}
+                } else if(isa<BitCastInst>(Ins)) {//for 2 level pointers, there can be load instead of bitcast as operand of free
+                    ptrNode.name=dyn_cast<Value>(&Ins);
+                    ptrNode.vertexTy=ptr;
+                    if (HeapOFGraph.hasVertex(ptrNode.name)) {
+                        ptrNode = HeapOFGraph.getVertex(ptrNode.name);
+                    } else {
+                        if(! HeapOFGraph.insertVertex(ptrNode)) {
+                            //errs()<<"\n now it is totaly wrong";
                         } else {
-                            if(! HeapOFGraph.vertices.insert(ptrNode).second) {
-                                //errs()<<"\n now it is totaly wrong";
-                            } else {
-                                //errs()<<"\nIt is added freom here";
-                            }
+                            //errs()<<"\nIt is added freom here";
                         }
-                        F flowEdge;
+                    }
+                    F flowEdge;
+                    flowEdge.tail=ptrNode;
+                    flowEdge.head=freeNode;
+                    annotateEdge(flowEdge,I);
+                    if(HeapOFGraph.hasFlow(flowEdge)) {
+                    } else {
+                        HeapOFGraph.insertVertex(freeNode);
+                        freeNode=HeapOFGraph.getVertex(freeNode.name);
                         flowEdge.tail=ptrNode;
                         flowEdge.head=freeNode;
                         annotateEdge(flowEdge,I);
-                        if(HeapOFGraph.flows.find(flowEdge) != HeapOFGraph.flows.end()) {
-                        } else {
-                            HeapOFGraph.vertices.insert(freeNode);
-                            freeNode=*(HeapOFGraph.vertices.find(freeNode));
-                            flowEdge.tail=ptrNode;
-                            flowEdge.head=freeNode;
-                            annotateEdge(flowEdge,I);
-                            flowEdge.location=I.getDebugLoc();
-                            //errs()<<"Line number 9 "<<I.getDebugLoc().getLine();
-                            if(HeapOFGraph.flows.insert(flowEdge).second){
-                                if(isa<Argument>(ptrNode.name)){ 
-                                    for(Argument &A : I.getFunction()->args()) {
-                                        Value* arg = dyn_cast<Value>(&A);
-                                        if(arg == ptrNode.name || arg == dyn_cast<Instruction>(ptrNode.name)->getOperand(0)) {
-                                            Argument *arg = dyn_cast<Argument>(ptrNode.name);
-                                            FuncSummary summary;
-                                            summary.funcName = I.getFunction();
-                                            if(allFuncSummaries.find(summary)!=allFuncSummaries.end()) {
-                                                fsit = allFuncSummaries.find(summary);
-                                                argTransformIt = fsit->argTransforms.begin();
-                                                advance(argTransformIt,(dyn_cast<Argument>(arg))->getArgNo());
-                                                 fsit->argTransforms.insert(argTransformIt,deallocator);
-                                                 argTransform newTF;
-                                                newTF.typeOfTransform=deallocator;
-                                                newTF.argumentNumber=(dyn_cast<Argument>(arg))->getArgNo();
-                                                fsit->argumentTransform.insert(newTF);
-                                            }
-                                            
-                                            break;
+                        flowEdge.location=Locations.intern(I.getDebugLoc());
+                        //errs()<<"Line number 9 "<<I.getDebugLoc().getLine();
+                        if(HeapOFGraph.insertFlow(flowEdge)){
+                            if(isa<Argument>(ptrNode.name)){ 
+                                for(Argument &A : I.getFunction()->args()) {
+                                    Value* arg = dyn_cast<Value>(&A);
+                                    if(arg == ptrNode.name || arg == dyn_cast<Instruction>(ptrNode.name)->getOperand(0)) {
+                                        Argument *arg = dyn_cast<Argument>(ptrNode.name);
+                                        if(FuncSummary *fsit = summaryOf(I.getFunction())) {
+                                             fsit->addArgTransform(dyn_cast<Argument>(arg)->getArgNo(), deallocator);
                                         }
-                                    }
-                                } else if(isa<GlobalVariable>(ptrNode.name)) {
-                                    //This is a deallocation of a global variable
-                                    FuncSummary summary;
-                                    summary.funcName = I.getFunction();
-                                    if(allFuncSummaries.find(summary)!=allFuncSummaries.end()) {
-                                        fsit = allFuncSummaries.find(summary);
-                                        fsit->globalDealloc.insert(freeNode.name);
-                                    }
-                                } else if(isa<GlobalVariable>(dyn_cast<Instruction>(ptrNode.name)->getOperand(0))) {
-                                    FuncSummary summary;
-                                    summary.funcName = I.getFunction();
-                                    if(allFuncSummaries.find(summary)!=allFuncSummaries.end()) {
-                                        fsit = allFuncSummaries.find(summary);
-                                        Value *v=dyn_cast<Value>(dyn_cast<Instruction>(freeNode.name)->getOperand(0));
-                                        fsit->globalDealloc.insert(v);
+                                        
+                                        break;
                                     }
                                 }
+                            } else if(isa<GlobalVariable>(ptrNode.name)) {
+                                //This is a deallocation of a global variable
+                                if(FuncSummary *fsit = summaryOf(I.getFunction())) {
+                                    FuncSummary::addValue(fsit->globalDealloc, freeNode.name);
+                                }
+                            } else if(isa<GlobalVariable>(dyn_cast<Instruction>(ptrNode.name)->getOperand(0))) {
+                                if(FuncSummary *fsit = summaryOf(I.getFunction())) {
+                                    Value *v=dyn_cast<Value>(dyn_cast<Instruction>(freeNode.name)->getOperand(0));
+                                    FuncSummary::addValue(fsit->globalDealloc, v);
+                                }
                             }
                         }
-                    } else if (isa<LoadInst>(Ins) && isa<PointerType>(Ins.getType())) {
-                        ptrNode.name=dyn_cast<Value>(&Ins);
-                        if(ConstantExpr *cexp = dyn_cast<ConstantExpr>(Ins.getOperand(0))) {
-                            if(isa<GlobalVariable>(cexp->getOperand(0))) {
-                                ptrNode.name=dyn_cast<Value>(cexp->getOperand(0));
-                            }
+                    }
+                } else if (isa<LoadInst>(Ins) && isa<PointerType>(Ins.getType())) {
+                    ptrNode.name=dyn_cast<Value>(&Ins);
+                    if(ConstantExpr *cexp = dyn_cast<ConstantExpr>(Ins.getOperand(0))) {
+                        if(isa<GlobalVariable>(cexp->getOperand(0))) {
+                            ptrNode.name=dyn_cast<Value>(cexp->getOperand(0));
                         }
-                        
-                        if (HeapOFGraph.vertices.find(ptrNode) != HeapOFGraph.vertices.end()) {
-                            ptrNode=*(HeapOFGraph.vertices.find(ptrNode));
-                            HeapOFGraph.vertices.insert(freeNode);
-                            freeNode=*(HeapOFGraph.vertices.find(freeNode));
+                    }
+                    
+                    if (HeapOFGraph.hasVertex(ptrNode.name)) {
+                        ptrNode=HeapOFGraph.getVertex(ptrNode.name);
+                        HeapOFGraph.insertVertex(freeNode);
+                        freeNode=HeapOFGraph.getVertex(freeNode.name);
+                        F flowEdge;
+                        flowEdge.tail=ptrNode;
+                        flowEdge.head=freeNode;
+                        annotateEdge(flowEdge,I); 
+                        flowEdge.location=Locations.intern(I.getDebugLoc());
+                        //errs()<<"Line number 10 "<<I.getDebugLoc().getLine();
+                        HeapOFGraph.insertFlow(flowEdge);
+                    }
+                } else if (isa<CallInst>(Ins)) {
+                    if (isMallocFunction(Ins)) {
+                        ptrNode.vertexTy=obj;
+                        ptrNode.name=dyn_cast<Value>(&Ins);
+                        if (HeapOFGraph.hasVertex(ptrNode.name)) {
+                            //errs()<<"\nDirect call from alloc to free 1";
+                            ptrNode=HeapOFGraph.getVertex(ptrNode.name);
                             F flowEdge;
                             flowEdge.tail=ptrNode;
                             flowEdge.head=freeNode;
+                            HeapOFGraph.insertVertex(freeNode);
+                            freeNode=HeapOFGraph.getVertex(freeNode.name);
                             annotateEdge(flowEdge,I); 
-                            flowEdge.location=I.getDebugLoc();
-                            //errs()<<"Line number 10 "<<I.getDebugLoc().getLine();
-                            HeapOFGraph.flows.insert(flowEdge);
-                        }
-                    } else if (isa<CallInst>(Ins)) {
-                        if (isMallocFunction(Ins)) {
-                            ptrNode.vertexTy=obj;
-                            ptrNode.name=dyn_cast<Value>(&Ins);
-                            if (HeapOFGraph.vertices.find(ptrNode) != HeapOFGraph.vertices.end()) {
-                                //errs()<<"\nDirect call from alloc to free 1";
-                                ptrNode=*(HeapOFGraph.vertices.find(ptrNode));
-                                F flowEdge;
-                                flowEdge.tail=ptrNode;
-                                flowEdge.head=freeNode;
-                                HeapOFGraph.vertices.insert(freeNode);
-                                freeNode=*(HeapOFGraph.vertices.find(freeNode));
-                                annotateEdge(flowEdge,I); 
-                                flowEdge.location=I.getDebugLoc();
-                                //auto *Scope = cast<DIScope>(I.getDebugLoc()->getScope());
-                                //std::string fileName = Scope->getFilename().str();
-                                //outs()<<"in file : "<<fileName<<"\n";
-                                //errs()<<"Line number : "<<I.getDebugLoc().getLine();
-                                HeapOFGraph.flows.insert(flowEdge);
-                            } else {
-                                //errs()<<"\nDirect call from alloc to free 2";
-                                F flowEdge;
-                                flowEdge.tail=ptrNode;
-                                flowEdge.head=freeNode;
-                                HeapOFGraph.vertices.insert(freeNode);
-                                freeNode=*(HeapOFGraph.vertices.find(freeNode));
-                                annotateEdge(flowEdge,I); 
-                                flowEdge.location=I.getDebugLoc();
-                                //errs()<<"Line number 11 "<<I.getDebugLoc().getLine();
-                                HeapOFGraph.flows.insert(flowEdge);
-                            }
-                        }
-                    } else {
-                        ptrNode.vertexTy=ptr;
-                        ptrNode.name=dyn_cast<Value>(&Ins);
-                        if (HeapOFGraph.vertices.find(ptrNode) != HeapOFGraph.vertices.end()) {
-                            ptrNode=*(HeapOFGraph.vertices.find(ptrNode));
+                            flowEdge.location=Locations.intern(I.getDebugLoc());
+                            //auto *Scope = cast<DIScope>(I.getDebugLoc()->getScope());
+                            //std::string fileName = Scope->getFilename().str();
+                            //outs()<<"in file : "<<fileName<<"\n";
+                            //errs()<<"Line number : "<<I.getDebugLoc().getLine();
+                            HeapOFGraph.insertFlow(flowEdge);
+                        } else {
+                            //errs()<<"\nDirect call from alloc to free 2";
                             F flowEdge;
                             flowEdge.tail=ptrNode;
                             flowEdge.head=freeNode;
-                            HeapOFGraph.vertices.insert(freeNode);
+                            HeapOFGraph.insertVertex(freeNode);
+                            freeNode=HeapOFGraph.getVertex(freeNode.name);
                             annotateEdge(flowEdge,I); 
-                            flowEdge.location=I.getDebugLoc();
+                            flowEdge.location=Locations.intern(I.getDebugLoc());
                             //errs()<<"Line number 11 "<<I.getDebugLoc().getLine();
-                            HeapOFGraph.flows.insert(flowEdge);
+                            HeapOFGraph.insertFlow(flowEdge);
                         }
                     }
+                } else {
+                    ptrNode.vertexTy=ptr;
+                    ptrNode.name=dyn_cast<Value>(&Ins);
+                    if (HeapOFGraph.hasVertex(ptrNode.name)) {
+                        ptrNode=HeapOFGraph.getVertex(ptrNode.name);
+                        F flowEdge;
+                        flowEdge.tail=ptrNode;
+                        flowEdge.head=freeNode;
+                        HeapOFGraph.insertVertex(freeNode);
+                        annotateEdge(flowEdge,I); 
+                        flowEdge.location=Locations.intern(I.getDebugLoc());
+                        //errs()<<"Line number 11 "<<I.getDebugLoc().getLine();
+                        HeapOFGraph.insertFlow(flowEdge);
+                    }
                 }
             }
-            }
         }
         void addCopy(BasicBlock &B, Instruction &I) {
             V srcNode, destNode;
@@ -1945,50 +2938,33 @@ namespace {
             srcNode.vertexTy=ptr;
             if(isa<Argument>(srcNode.name)) {
 
-            } else if(HeapOFGraph.vertices.find(srcNode) != HeapOFGraph.vertices.end()) {
-                vit=HeapOFGraph.vertices.find(srcNode);
-                srcNode = *vit;
+            } else if(HeapOFGraph.hasVertex(srcNode.name)) {
+                srcNode = HeapOFGraph.getVertex(srcNode.name);
                 destNode.name=dyn_cast<Value>(&I);
                 destNode.vertexTy=ptr;
-                if(HeapOFGraph.vertices.find(destNode) != HeapOFGraph.vertices.end()) {
+                if(HeapOFGraph.hasVertex(destNode.name)) {
                 } else {
-                    HeapOFGraph.vertices.insert(destNode);
+                    HeapOFGraph.insertVertex(destNode);
                 }
                 F flowEdge;
                 flowEdge.head=destNode;
                 flowEdge.tail=srcNode;
                 annotateEdge(flowEdge,I);
-                if(HeapOFGraph.flows.find(flowEdge) != HeapOFGraph.flows.end()) {
+                if(HeapOFGraph.hasFlow(flowEdge)) {
                         } else {
                                 if(isa<Argument>(destNode.name)) {
                                     for(Argument &A : I.getFunction()->args()) {
                                         Value* arg = dyn_cast<Value>(&A);
                                         if(arg == destNode.name) {
-                                            FuncSummary summary;
-                                            summary.funcName = I.getFunction();
-                                            if(allFuncSummaries.find(summary)!=allFuncSummaries.end()) {
-                                                fsit = allFuncSummaries.find(summary);
-                                                argTransformIt = fsit->argTransforms.begin();
-                                                advance(argTransformIt,(dyn_cast<Argument>(arg))->getArgNo());
-                                                fsit->argTransforms.insert(argTransformIt,deallocator);
-                                                argTransform newTF;
-                                                newTF.typeOfTransform=deallocator;
-                                                newTF.argumentNumber=(dyn_cast<Argument>(arg))->getArgNo();
-                                                fsit->argumentTransform.insert(newTF);
+                                            if(FuncSummary *fsit = summaryOf(I.getFunction())) {
+                                                fsit->addArgTransform(dyn_cast<Argument>(arg)->getArgNo(), deallocator);
                                             }
                                             break;
                                         }
                                     }
                                 }
                             if(isa<GlobalVariable>(flowEdge.head.name) && isa<GlobalVariable>(flowEdge.tail.name)) {
-                                predBB fromBB;
-                                fromBB.bb =&B;
-                                if(allBBs.find(fromBB) != allBBs.end()) {
-                                    fromBB = *(allBBs.find(fromBB));
-                                    for (Value *c : fromBB.entriConditions) {
-                                        flowEdge.conditions.insert(c);
-                                    }
-                                }
+                                flowEdge.conditions = Conditions.unite(flowEdge.conditions, guardOf(&B));
                             } else {
                                 annotateEdge(flowEdge,I);
                             }
@@ -1997,33 +2973,30 @@ namespace {
                             if(Instruction *srcIns = dyn_cast<Instruction>(srcNode.name)) {
                                 if(isMallocFunction(*srcIns)) {
                                 if(srcIns->getDebugLoc()) {
-                                    flowEdge.location=srcIns->getDebugLoc();
-                                    HeapOFGraph.flows.insert(flowEdge);
+                                    flowEdge.location=Locations.intern(srcIns->getDebugLoc());
+                                    HeapOFGraph.insertFlow(flowEdge);
                                 }
                                 } else {
                                 if(srcIns->getDebugLoc()) {
-                                    flowEdge.location=srcIns->getDebugLoc();
-                                    HeapOFGraph.flows.insert(flowEdge);
+                                    flowEdge.location=Locations.intern(srcIns->getDebugLoc());
+                                    HeapOFGraph.insertFlow(flowEdge);
                                 } else if(Instruction *destIns = dyn_cast<Instruction>(destNode.name)) {
                                     if(destIns->getDebugLoc()) {
-                                        flowEdge.location=destIns->getDebugLoc();
-                                        HeapOFGraph.flows.insert(flowEdge);
+                                        flowEdge.location=Locations.intern(destIns->getDebugLoc());
+                                        HeapOFGraph.insertFlow(flowEdge);
                                     }
                                 }
                                 }
                             } else if(Instruction *destIns = dyn_cast<Instruction>(destNode.name)) {
                                 if(destIns->getDebugLoc()) {
-                                    flowEdge.location=destIns->getDebugLoc();
-                                    HeapOFGraph.flows.insert(flowEdge);
+                                    flowEdge.location=Locations.intern(destIns->getDebugLoc());
+                                    HeapOFGraph.insertFlow(flowEdge);
                                 }
                             } else if(Instruction *srcIns = dyn_cast<Instruction>(srcNode.name)) {
                                 if(srcIns->getDebugLoc()) {
-                                    flowEdge.location=srcIns->getDebugLoc();
-                                    HeapOFGraph.flows.insert(flowEdge);
+                                    flowEdge.location=Locations.intern(srcIns->getDebugLoc());
+                                    HeapOFGraph.insertFlow(flowEdge);
                                 }
-                            } else {
-                                I.dump();
-                                errs()<<"\nEdge not added here";
                             }
                         }
             } else {
@@ -2031,60 +3004,44 @@ namespace {
         }
         void addGepToBitcast(BasicBlock &B, Instruction &I) {
             V srcNode, destNode;
-            std::set<V>::iterator dit;
             srcNode.name=dyn_cast<Value>(&I);
             srcNode.vertexTy=ptr;
-            if(HeapOFGraph.vertices.find(srcNode) != HeapOFGraph.vertices.end()) {
+            if(HeapOFGraph.hasVertex(srcNode.name)) {
                 GetElementPtrInst *gep = dyn_cast<GetElementPtrInst>(I.getOperand(0));
-                vit=HeapOFGraph.vertices.find(srcNode);
-                srcNode = *vit;
+                srcNode = HeapOFGraph.getVertex(srcNode.name);
                 destNode.name=dyn_cast<Value>(gep->getOperand(0));
-                if(HeapOFGraph.vertices.find(destNode) != HeapOFGraph.vertices.end()) {
-                    dit = HeapOFGraph.vertices.find(destNode);
-                    destNode = *dit;
+                if(HeapOFGraph.hasVertex(destNode.name)) {
+                    destNode = HeapOFGraph.getVertex(destNode.name);
                 } else {
                     if(Instruction *ins = dyn_cast<Instruction>(gep->getOperand(0))) {
                         if(isMallocFunction(*ins)) {
-                            errs()<<".";
                             destNode.vertexTy = obj;
                         } else {
                             destNode.vertexTy = ptr;
                         }
                     }
                     
-                    HeapOFGraph.vertices.insert(destNode);
-                    dit = HeapOFGraph.vertices.find(destNode);
-                    destNode = *dit;
+                    HeapOFGraph.insertVertex(destNode);
+                    destNode = HeapOFGraph.getVertex(destNode.name);
                 }
-                if((*dit).vertexTy == obj) {
+                if(destNode.vertexTy == obj) {
                     //errs()<<"\nCaught here";
                 } else {
                     F flowEdge;
                     flowEdge.head=destNode;
                     flowEdge.tail=srcNode;
                     annotateEdge(flowEdge,I);
-                    if(HeapOFGraph.flows.find(flowEdge) != HeapOFGraph.flows.end()) {
+                    if(HeapOFGraph.hasFlow(flowEdge)) {
                     } else {
                         if(isa<Argument>(destNode.name)) {
                             for(Argument &A : I.getFunction()->args()) {
                                 Value* arg = dyn_cast<Value>(&A);
                                 if(arg == destNode.name) {
-                                    FuncSummary summary;
-                                    summary.funcName = I.getFunction();
-                                    if(allFuncSummaries.find(summary)!=allFuncSummaries.end()) {
-                                        std::set<FuncSummary>::iterator fsitl;
-                                        std::list<funcType>::iterator argTransformItl;
-                                        fsitl = allFuncSummaries.find(summary);
-                                        argTransformItl = fsitl->argTransforms.begin();
-                                        if(find(fsitl->argTransforms.begin(),fsitl->argTransforms.end(),allocator) != fsitl->argTransforms.end()) {
+                                    if(FuncSummary *fsitl = summaryOf(I.getFunction())) {
+                                        if(fsitl->allTransforms() & allocatesArg) {
                                             fsitl->functionType=allocator;
-                                        } else {
-                                            fsitl->argTransforms.insert(argTransformItl,allocator);
                                         }
-                                        argTransform newTF;
-                                        newTF.typeOfTransform=deallocator;
-                                        newTF.argumentNumber=(dyn_cast<Argument>(arg))->getArgNo();
-                                        fsitl->argumentTransform.insert(newTF);
+                                        fsitl->addArgTransform(dyn_cast<Argument>(arg)->getArgNo(), deallocator);
                                         fsitl->functionType=allocator;
                                     }
                                     break;
@@ -2092,24 +3049,17 @@ namespace {
                             }
                         }
                         if(isa<GlobalVariable>(flowEdge.head.name) && isa<GlobalVariable>(flowEdge.tail.name)) {
-                            predBB fromBB;
-                            fromBB.bb =&B;
-                            if(allBBs.find(fromBB) != allBBs.end()) {
-                                fromBB = *(allBBs.find(fromBB));
-                                for (Value *c : fromBB.entriConditions) {
-                                    flowEdge.conditions.insert(c);
-                                }
-                            }
+                            flowEdge.conditions = Conditions.unite(flowEdge.conditions, guardOf(&B));
                         } else {
                             annotateEdge(flowEdge,I);
                         }
                         if(I.getDebugLoc()) {
-                            flowEdge.location=I.getDebugLoc();
+                            flowEdge.location=Locations.intern(I.getDebugLoc());
                         } else if(gep->getDebugLoc()){
-                            flowEdge.location=gep->getDebugLoc();
+                            flowEdge.location=Locations.intern(gep->getDebugLoc());
                         }
                         //errs()<<"Line number 12 "<<I.getDebugLoc().getLine();
-                        HeapOFGraph.flows.insert(flowEdge);
+                        HeapOFGraph.insertFlow(flowEdge);
                     }
                 }
             }
@@ -2124,14 +3074,13 @@ namespace {
                 V srcNode;
                 srcNode.name=dyn_cast<Value>(Phi->getIncomingValue(i));
                 srcNode.vertexTy=ptr;
-                if(HeapOFGraph.vertices.find(srcNode) != HeapOFGraph.vertices.end()) {
-                    srcNode=*(HeapOFGraph.vertices.find(srcNode));
-                    if(HeapOFGraph.vertices.find(destNode) != HeapOFGraph.vertices.end()) {
+                if(HeapOFGraph.hasVertex(srcNode.name)) {
+                    srcNode=HeapOFGraph.getVertex(srcNode.name);
+                    if(HeapOFGraph.hasVertex(destNode.name)) {
                         //This is a copy to existing node.
-                        vit=HeapOFGraph.vertices.find(destNode);
-                        destNode = *vit;
+                        destNode = HeapOFGraph.getVertex(destNode.name);
                     } else {
-                        HeapOFGraph.vertices.insert(destNode);
+                        HeapOFGraph.insertVertex(destNode);
                     }
                     F flowEdge;
                     flowEdge.head=destNode;
@@ -2141,29 +3090,20 @@ namespace {
                     circularEdge.tail=destNode;
                     annotateEdge(circularEdge,I);
                     annotateEdge(flowEdge,I);
-                    if(HeapOFGraph.flows.find(flowEdge) != HeapOFGraph.flows.end()) {
-                    } else if (HeapOFGraph.flows.find(circularEdge) != HeapOFGraph.flows.end()) {
+                    if(HeapOFGraph.hasFlow(flowEdge)) {
+                    } else if (HeapOFGraph.hasFlow(circularEdge)) {
                     } else {
                         if(isa<Argument>(destNode.name)) {
                             for(Argument &A : I.getFunction()->args()) {
                                 Value* arg = dyn_cast<Value>(&A);
                                 if(arg == destNode.name) {
                                     //errs()<<"\nhead is an arg in phi\n";
-                                    FuncSummary summary;
-                                    summary.funcName = I.getFunction();
-                                    if(allFuncSummaries.find(summary)!=allFuncSummaries.end()) {
-                                        fsit = allFuncSummaries.find(summary);
+                                    if(FuncSummary *fsit = summaryOf(I.getFunction())) {
                                         //fsit->argTransforms.push_back(allocator);
                                         //fsit->functionType=allocator;
-                                        argTransformIt = fsit->argTransforms.begin();
-                                        advance(argTransformIt,(dyn_cast<Argument>(arg))->getArgNo());
                                         //errs()<<"\n adding dealloc at index 4: "<<(dyn_cast<Argument>(arg))->getArgNo()<<" for function : "<< I.getFunction()->getName();
                             
-                                        fsit->argTransforms.insert(argTransformIt,deallocator);
-                                        argTransform newTF;
-                                        newTF.typeOfTransform=deallocator;
-                                        newTF.argumentNumber=(dyn_cast<Argument>(arg))->getArgNo();
-                                        fsit->argumentTransform.insert(newTF);
+                                        fsit->addArgTransform(dyn_cast<Argument>(arg)->getArgNo(), deallocator);
                                     }
                                     break;
                                 }
@@ -2177,28 +3117,27 @@ namespace {
                         //    Instruction &Ins(*BI);
                         //    if(Ins.getOperand(0) == dyn_cast<Value>(&I) ){//|| dyn_cast<Instruction>(Ins.getOperand(1)) == dyn_cast<Instruction>(I)) {
                         //        errs()<<"\n REached here ";
-                        //        flowEdge.location=Ins.getDebugLoc();
+                        //        flowEdge.location=Locations.intern(Ins.getDebugLoc());
                         //    }
                         //}
                         //srcNode.name->dump();
                         if(Instruction *srcIns = dyn_cast<Instruction>(srcNode.name)) {
                             if(srcIns->getDebugLoc()) {
-                                flowEdge.location=srcIns->getDebugLoc();
-                                HeapOFGraph.flows.insert(flowEdge);        
+                                flowEdge.location=Locations.intern(srcIns->getDebugLoc());
+                                HeapOFGraph.insertFlow(flowEdge);        
                             }
                         } else if(Instruction *destIns = dyn_cast<Instruction>(destNode.name)) {
                             if(destIns->getDebugLoc()) {
-                                flowEdge.location=destIns->getDebugLoc();
-                                HeapOFGraph.flows.insert(flowEdge);
+                                flowEdge.location=Locations.intern(destIns->getDebugLoc());
+                                HeapOFGraph.insertFlow(flowEdge);
                             }
                         }
                         //if(!(dyn_cast<Instruction>(srcNode.name))->getDebugLoc()) {
                         //    errs()<<"\nIt is unknown";
                          else {
-                             errs()<<"\nEdge not added";
                         //errs()<<"\nLine number 13 :"<<(dyn_cast<Instruction>(srcNode.name))->getDebugLoc().getLine()<<"\n";
                         //flowEdge.location=(dyn_cast<Instruction>(srcNode.name))->getDebugLoc();
-                        //HeapOFGraph.flows.insert(flowEdge);
+                        //HeapOFGraph.insertFlow(flowEdge);
                         }
                     }
                 }
@@ -2220,9 +3159,8 @@ namespace {
             StoreInst *storIns = dyn_cast<StoreInst>(&I);
             V srcNode, destNode;
             srcNode.name=dyn_cast<Value>(storIns->getOperand(0));
-            if(HeapOFGraph.vertices.find(srcNode) != HeapOFGraph.vertices.end()) {
-                vit=HeapOFGraph.vertices.find(srcNode);
-                srcNode = *vit;
+            if(HeapOFGraph.hasVertex(srcNode.name)) {
+                srcNode = HeapOFGraph.getVertex(srcNode.name);
                 destNode.name=dyn_cast<Value>(storIns->getOperand(1));
                 if(dyn_cast<Argument>(storIns->getOperand(1))) {
                 //    errs()<<"\nIts global";
@@ -2247,26 +3185,22 @@ namespace {
                     }
                 }
                 destNode.vertexTy=ptr;
-                if(HeapOFGraph.vertices.find(destNode) != HeapOFGraph.vertices.end()) {
+                if(HeapOFGraph.hasVertex(destNode.name)) {
                     //This is a store to existing node.
-                    vit=HeapOFGraph.vertices.find(destNode);
-                    destNode = *vit;
+                    destNode = HeapOFGraph.getVertex(destNode.name);
                 } else {
-                    HeapOFGraph.vertices.insert(destNode);
+                    HeapOFGraph.insertVertex(destNode);
                 }
                 F flowEdge;
                 flowEdge.tail=srcNode;
                 flowEdge.head=destNode;
                 annotateEdge(flowEdge,I);
-                if(HeapOFGraph.flows.find(flowEdge) != HeapOFGraph.flows.end()) {
+                if(HeapOFGraph.hasFlow(flowEdge)) {
                 //    errs()<<"\nRepeat can be detected here";
                 } else {
-                    FuncSummary summary;
                     if(isa<GlobalVariable>(destNode.name)) {
-                        summary.funcName = I.getFunction();
-                        if(allFuncSummaries.find(summary)!=allFuncSummaries.end()) {
-                            fsit = allFuncSummaries.find(summary);
-                            fsit->globalAlloc.insert(dyn_cast<Value>(storIns));
+                        if(FuncSummary *fsit = summaryOf(I.getFunction())) {
+                            FuncSummary::addValue(fsit->globalAlloc, dyn_cast<Value>(storIns));
                         }
                     }
                     for(Argument &A : I.getFunction()->args()) {
@@ -2276,9 +3210,9 @@ namespace {
                     }
                     }
                     annotateEdge(flowEdge,I);
-                    flowEdge.location=I.getDebugLoc();
+                    flowEdge.location=Locations.intern(I.getDebugLoc());
                     //errs()<<"Line number 14 "<<I.getDebugLoc().getLine();
-                    HeapOFGraph.flows.insert(flowEdge);
+                    HeapOFGraph.insertFlow(flowEdge);
                 }
             }
         }
@@ -2289,30 +3223,27 @@ namespace {
                 retNode.name = dyn_cast<Value>(I.getOperand(0));
                 retIns.name=dyn_cast<Value>(&I);
                 retIns.vertexTy=ptr;
-                if(HeapOFGraph.vertices.find(retNode) != HeapOFGraph.vertices.end()) {
-                    retNode=*(HeapOFGraph.vertices.find(retNode));
-                    if(HeapOFGraph.vertices.find(retIns) != HeapOFGraph.vertices.end()) {
-                        retIns=*(HeapOFGraph.vertices.find(retIns));
+                if(HeapOFGraph.hasVertex(retNode.name)) {
+                    retNode=HeapOFGraph.getVertex(retNode.name);
+                    if(HeapOFGraph.hasVertex(retIns.name)) {
+                        retIns=HeapOFGraph.getVertex(retIns.name);
                     } else {
-                        HeapOFGraph.vertices.insert(retIns);
-                        retIns=*(HeapOFGraph.vertices.find(retIns));
+                        HeapOFGraph.insertVertex(retIns);
+                        retIns=HeapOFGraph.getVertex(retIns.name);
                     }
                     F flowEdge;
                     flowEdge.tail=retNode;
                     flowEdge.head=retIns;
                     annotateEdge(flowEdge,I);
-                    flowEdge.location=I.getDebugLoc();
-                    if(HeapOFGraph.flows.find(flowEdge) != HeapOFGraph.flows.end()) {
+                    flowEdge.location=Locations.intern(I.getDebugLoc());
+                    if(HeapOFGraph.hasFlow(flowEdge)) {
                     } else {
-                        HeapOFGraph.flows.insert(flowEdge);
-                    }
-                    if(HeapOFGraph.vertices.find(retNode) != HeapOFGraph.vertices.end()) {
-                        if(Fun->hasMetadata("summary")) {
-                            FuncSummary summary;
-                            summary.funcName=Fun;
-                            if(allFuncSummaries.find(summary)!=allFuncSummaries.end()) {
-                                fsit = allFuncSummaries.find(summary);
-                                fsit->returnValues.insert(dyn_cast<Value>(I.getOperand(0)));
+                        HeapOFGraph.insertFlow(flowEdge);
+                    }
+                    if(HeapOFGraph.hasVertex(retNode.name)) {
+                        if(summaryGenerated(*Fun)) {
+                            if(FuncSummary *fsit = summaryOf(Fun)) {
+                                FuncSummary::addValue(fsit->returnValues, dyn_cast<Value>(I.getOperand(0)));
                                 if(fsit->returnValues.size()>0) {
                                     //errs()<<"\n added for "<<Fun->getName()<<"\n";
                                 }
@@ -2323,6 +3254,10 @@ namespace {
                 }
             }
         }
+        bool summaryGenerated(Function &F) {
+            FuncSummary *summary = summaryOf(&F);
+            return summary && summary->generated;
+        }
         void applyFunctionSummary(BasicBlock &B, Instruction &I) {
             CallInst *call=dyn_cast<CallInst>(&I);
             Function *Fun = call->getCalledFunction();
@@ -2345,30 +3280,33 @@ namespace {
                             }
                         }
                         actualArgNode.name=A;
-                        if(HeapOFGraph.vertices.find(actualArgNode) != HeapOFGraph.vertices.end()) {
-                            if(HeapOFGraph.vertices.find(formalArgNode) != HeapOFGraph.vertices.end()) {
-                                formalArgNode=*(HeapOFGraph.vertices.find(formalArgNode));
+                        if(HeapOFGraph.hasVertex(actualArgNode.name)) {
+                            if(HeapOFGraph.hasVertex(formalArgNode.name)) {
+                                formalArgNode=HeapOFGraph.getVertex(formalArgNode.name);
                             } else {
                                 formalArgNode.vertexTy=ptr;
-                                HeapOFGraph.vertices.insert(formalArgNode);
-                                formalArgNode=*(HeapOFGraph.vertices.find(formalArgNode));
+                                HeapOFGraph.insertVertex(formalArgNode);
+                                formalArgNode=HeapOFGraph.getVertex(formalArgNode.name);
                             }
                             F flowEdge;
                             flowEdge.tail=actualArgNode;
                             flowEdge.head=formalArgNode;
                             annotateEdge(flowEdge,I);
-                            flowEdge.location=I.getDebugLoc();
+                            flowEdge.location=Locations.intern(I.getDebugLoc());
                             //errs()<<"Line number 15 "<<I.getDebugLoc().getLine();
-                            HeapOFGraph.flows.insert(flowEdge);
+                            HeapOFGraph.insertFlow(flowEdge);
                         }
                         iterator++;
                     }
                 }
-                if(Fun->hasMetadata("summary")) {
+                if(summaryGenerated(*Fun)) {
                     //errs()<<"From a call instruction, the function has summary already: "<<Fun->getName()<<"\n";
                     applySummary(*Fun,*call);
                 } else {
                     //errs()<<"From a function call, the function does not already have a summary. So generating summary of:"<<Fun->getName()<<"\n";
+                    if(HeapOFGraph.record) { //the pass of the callee would be mixed into the recorded one
+                        HeapOFGraph.record->cacheable = false;
+                    }
                     generateFunctionSummary(*Fun);
                     applySummary(*Fun,*call);
                 }
@@ -2386,213 +3324,176 @@ namespace {
             //3. summary.argTransforms : whether any arguments are being allocated or deallocated.
             //4. summary.returnValues : if a function returns pointer(s)
             //According to allocator or deallocator, for each function call, we need to create new nodes, using the function summary.
-            FuncSummary summary;
-            summary.funcName=&F;
-            if(allFuncSummaries.find(summary)!=allFuncSummaries.end()) {
-                //errs()<<"\n found summary of :"<<F.getName()<<"\n";
-                fsit = allFuncSummaries.find(summary);
-                summary=*fsit;
-                //if(summary.functionType==allocator) {
-                //    errs()<<"\n I am anything further";
-                    //addReturnToCallSite(I,fsit);
-                //}
+            FuncSummary *summary = summaryOf(&F);
+            if(!summary) {
+                return;
             }
-            if(isa<PointerType>(*(summary.retType))) {
-                if(summary.functionType == allocator) {
-                //    errs()<<"\nThis function allocates through return value";
-                }
-            } else if(summary.functionType == allocator) {
-                for(funcType t: summary.argTransforms) {
-                    if(t==allocator) {
-                    //    errs()<<"\n Allocator of arg detected in function type allocator";
-                        //To do: add edge from formal arg to actual arg
-                    } else if (t==deallocator) {
-                    //    errs()<<"\nDeallocator of arg detected in function type allocator";
-                    } else if (t==noop) {
-                    //    errs()<<"\nnoop of arg detected in function type allocator";
-                    }
+            //errs()<<"\n found summary of :"<<F.getName()<<"\n";
+            for(unsigned argNo = 0; argNo < summary->argTransforms.size(); argNo++) {
+                if(summary->argTransforms[argNo] & allocatesArg) {
+                    addAllocArg(I,argNo);
                 }
-                //}
-            }
-            //if(summary.argTransforms.size() > 0) {
-            //    //errs()<<"\nArg transforms is there for :";
-            //    //I.dump();
-            //    for(funcType t: summary.argTransforms) {
-            //        if (t==deallocator) {
-            //            addDeallocArg(summary,I);
-            //        } else if (t==allocator) {
-            //            addAllocArg(summary,I);
-            //        }
-            //    }
-            //}
-            if(summary.argumentTransform.size()>0) {
-                for(argTransform agt : summary.argumentTransform) {
-                    if(agt.typeOfTransform == allocator) {
-                        addAllocArg(summary,I,agt);
-                    } else if (agt.typeOfTransform == deallocator) {
-                        addDeallocArg(summary,I,agt);
-                    }
+                if(summary->argTransforms[argNo] & deallocatesArg) {
+                    addDeallocArg(I,argNo);
                 }
             }
-            if(summary.globalAlloc.size() > 0) {
-                addGlobalAlloc(summary.globalAlloc,I);
+            if(summary->globalAlloc.size() > 0) {
+                addGlobalAlloc(summary->globalAlloc,I);
             }
-            if(summary.globalDealloc.size() > 0) {
-                addGlobalDealloc(summary.globalDealloc,I);
+            if(summary->globalDealloc.size() > 0) {
+                addGlobalDealloc(summary->globalDealloc,I);
             }
-            if(summary.returnValues.size() > 0) {
+            if(summary->returnValues.size() > 0) {
                 //errs()<<"\n\n\n\n\nAdding return to call site";
                 //I.dump();
-                addReturnToCallSite(I,fsit);
+                addReturnToCallSite(I,*summary);
             }
         }
-        void addReturnToCallSite(CallInst &I,std::set<FuncSummary>::iterator fsit ) {
-            FuncSummary summary;
-            summary=*fsit;
+        void addReturnToCallSite(CallInst &I, const FuncSummary &summary) {
             V retNode, receiverNode;
             receiverNode.name=dyn_cast<Value>(&I);
-            if(HeapOFGraph.vertices.find(receiverNode) != HeapOFGraph.vertices.end()) {
-                receiverNode=*(HeapOFGraph.vertices.find(receiverNode));
+            if(HeapOFGraph.hasVertex(receiverNode.name)) {
+                receiverNode=HeapOFGraph.getVertex(receiverNode.name);
             } else {
                 receiverNode.vertexTy=ptr;
-                HeapOFGraph.vertices.insert(receiverNode);
-                receiverNode=*(HeapOFGraph.vertices.find(receiverNode));
+                HeapOFGraph.insertVertex(receiverNode);
+                receiverNode=HeapOFGraph.getVertex(receiverNode.name);
             }
             for(Value *ret : summary.returnValues) {
                 retNode.name=ret;
                 //ret->dump();
-                if(HeapOFGraph.vertices.find(retNode) != HeapOFGraph.vertices.end()) {
-                    retNode=*(HeapOFGraph.vertices.find(retNode));
+                if(HeapOFGraph.hasVertex(retNode.name)) {
+                    retNode=HeapOFGraph.getVertex(retNode.name);
                     F flowEdge;
                     flowEdge.head=receiverNode;
                     flowEdge.tail=retNode;
                     annotateEdge(flowEdge,I);
-                    flowEdge.location=I.getDebugLoc();
+                    flowEdge.location=Locations.intern(I.getDebugLoc());
                     //errs()<<"Line number 16 "<<I.getDebugLoc().getLine();
-                    HeapOFGraph.flows.insert(flowEdge);
+                    HeapOFGraph.insertFlow(flowEdge);
                 }
             }
             
         }
-        void addGlobalDealloc(std::set<Value*> deallocSet, Instruction &I) {
+        void addGlobalDealloc(ArrayRef<Value*> deallocSet, Instruction &I) {
             for(Value *deallocIns : deallocSet) {
                 V freeNode,globalNode;
                 freeNode.name=deallocIns;
-                if(HeapOFGraph.vertices.find(freeNode) != HeapOFGraph.vertices.end()) {
-                    freeNode=*(HeapOFGraph.vertices.find(freeNode));
+                if(HeapOFGraph.hasVertex(freeNode.name)) {
+                    freeNode=HeapOFGraph.getVertex(freeNode.name);
                 }
                 Value *v=dyn_cast<Value>(dyn_cast<Instruction>(freeNode.name)->getOperand(0));
                 globalNode.name=v;//dyn_cast<Value>(dyn_cast<Instruction>(deallocIns->getOperand(0)));
-                if(HeapOFGraph.vertices.find(globalNode) != HeapOFGraph.vertices.end()) {
-                    globalNode=*(HeapOFGraph.vertices.find(globalNode));
+                if(HeapOFGraph.hasVertex(globalNode.name)) {
+                    globalNode=HeapOFGraph.getVertex(globalNode.name);
                 }
                 F flowEdge;
                 flowEdge.head=freeNode;
                 flowEdge.tail=globalNode;
                 annotateEdge(flowEdge,I);
-                flowEdge.location=I.getDebugLoc();
+                flowEdge.location=Locations.intern(I.getDebugLoc());
                 //errs()<<"Line number 17 "<<I.getDebugLoc().getLine();
-                HeapOFGraph.flows.insert(flowEdge);
+                HeapOFGraph.insertFlow(flowEdge);
             }
         }
-        void addGlobalAlloc(std::set<Value*> allocSet, Instruction &I) {
+        void addGlobalAlloc(ArrayRef<Value*> allocSet, Instruction &I) {
             for(Value *allocIns : allocSet) {
                 V globalNode,ptrNode,objNode;
                 F flowEdge1,flowEdge2;
                 Value *v=dyn_cast<Value>(dyn_cast<Instruction>(allocIns)->getOperand(1));
                 globalNode.name=v;//dyn_cast<Value>(dyn_cast<Instruction>(deallocIns->getOperand(0)));
-                if(HeapOFGraph.vertices.find(globalNode) != HeapOFGraph.vertices.end()) {
-                    globalNode=*(HeapOFGraph.vertices.find(globalNode));
+                if(HeapOFGraph.hasVertex(globalNode.name)) {
+                    globalNode=HeapOFGraph.getVertex(globalNode.name);
                 }
                 if(BitCastInst *bcI = dyn_cast<BitCastInst>((dyn_cast<Instruction>(allocIns))->getOperand(0))) {
                     if(CallInst *call = dyn_cast<CallInst>(bcI->getOperand(0))) {
                         objNode.name=dyn_cast<Value>(call);
-                        if(HeapOFGraph.vertices.find(objNode) != HeapOFGraph.vertices.end()) {
-                            objNode=*(HeapOFGraph.vertices.find(objNode));
+                        if(HeapOFGraph.hasVertex(objNode.name)) {
+                            objNode=HeapOFGraph.getVertex(objNode.name);
                             
                         }
                         ptrNode.name=dyn_cast<Value>(bcI);
-                        if(HeapOFGraph.vertices.find(ptrNode) != HeapOFGraph.vertices.end()) {
-                            ptrNode=*(HeapOFGraph.vertices.find(ptrNode));
+                        if(HeapOFGraph.hasVertex(ptrNode.name)) {
+                            ptrNode=HeapOFGraph.getVertex(ptrNode.name);
                         }
                         flowEdge1.tail=objNode;
                         flowEdge1.head=ptrNode;
                         annotateEdge(flowEdge1,I);
-                        flowEdge1.location=I.getDebugLoc();
+                        flowEdge1.location=Locations.intern(I.getDebugLoc());
                         //errs()<<"Line number 18 "<<I.getDebugLoc().getLine();
-                        HeapOFGraph.flows.insert(flowEdge1);
+                        HeapOFGraph.insertFlow(flowEdge1);
                         flowEdge2.tail=ptrNode;
                         flowEdge2.head=globalNode;
                         annotateEdge(flowEdge2,I);
-                        flowEdge2.location=I.getDebugLoc();
+                        flowEdge2.location=Locations.intern(I.getDebugLoc());
                         //errs()<<"Line number 19 "<<I.getDebugLoc().getLine();
-                        HeapOFGraph.flows.insert(flowEdge2);
+                        HeapOFGraph.insertFlow(flowEdge2);
                     }
                 }
             }
         }
-        void addDeallocArg(FuncSummary summary, Instruction &I, argTransform agt) {
+        void addDeallocArg(Instruction &I, unsigned argumentNumber) {
             CallInst *call=dyn_cast<CallInst>(&I);
             Function *calledFunction = dyn_cast<Function>(call->getCalledFunction());
-            Value *A = call->getArgOperand(agt.argumentNumber);
+            Value *A = call->getArgOperand(argumentNumber);
             V argNode,ptrNode;
             F flowEdge;
             argNode.name=A;
             argNode.vertexTy=ptr;
-            //if(HeapOFGraph.vertices.find(argNode) != HeapOFGraph.vertices.end()) {
-            //    argNode=*(HeapOFGraph.vertices.find(argNode));
+            //if(HeapOFGraph.hasVertex(argNode.name)) {
+            //    argNode=HeapOFGraph.getVertex(argNode.name);
             //} else {
-            //    HeapOFGraph.vertices.insert(argNode);
-            //    argNode=*(HeapOFGraph.vertices.find(argNode));
+            //    HeapOFGraph.insertVertex(argNode);
+            //    argNode=HeapOFGraph.getVertex(argNode.name);
             //}
-            Argument *formalArg = calledFunction->getArg(agt.argumentNumber);
+            Argument *formalArg = calledFunction->getArg(argumentNumber);
             ptrNode.name=dyn_cast<Value>(formalArg);
             ptrNode.vertexTy=ptr;
             flowEdge.head=ptrNode;
             flowEdge.tail=argNode;
             annotateEdge(flowEdge,I);
-            flowEdge.location=I.getDebugLoc();
-            HeapOFGraph.flows.insert(flowEdge);
+            flowEdge.location=Locations.intern(I.getDebugLoc());
+            HeapOFGraph.insertFlow(flowEdge);
         }
-        void addAllocArg(FuncSummary summary, Instruction &I, argTransform agt) {
+        void addAllocArg(Instruction &I, unsigned argumentNumber) {
             CallInst *call=dyn_cast<CallInst>(&I);
             Function *calledFunction = dyn_cast<Function>(call->getCalledFunction());
-            Value *A = call->getArgOperand(agt.argumentNumber);
+            Value *A = call->getArgOperand(argumentNumber);
             V argNode,ptrNode;
             F flowEdge;
             argNode.name=A;
             argNode.vertexTy=ptr;
-            //if(HeapOFGraph.vertices.find(argNode) != HeapOFGraph.vertices.end()) {
-            //    argNode=*(HeapOFGraph.vertices.find(argNode));
+            //if(HeapOFGraph.hasVertex(argNode.name)) {
+            //    argNode=HeapOFGraph.getVertex(argNode.name);
             //} else {
-            //    HeapOFGraph.vertices.insert(argNode);
-            //    argNode=*(HeapOFGraph.vertices.find(argNode));
+            //    HeapOFGraph.insertVertex(argNode);
+            //    argNode=HeapOFGraph.getVertex(argNode.name);
             //}
-            Argument *formalArg = calledFunction->getArg(agt.argumentNumber);
+            Argument *formalArg = calledFunction->getArg(argumentNumber);
             ptrNode.name=dyn_cast<Value>(formalArg);
             ptrNode.vertexTy=ptr;
             flowEdge.tail=ptrNode;
             flowEdge.head=argNode;
             annotateEdge(flowEdge,I);
-            flowEdge.location=I.getDebugLoc();
-            if(HeapOFGraph.flows.insert(flowEdge).second) {
+            flowEdge.location=Locations.intern(I.getDebugLoc());
+            if(HeapOFGraph.insertFlow(flowEdge)) {
             }
         }
-        void addDeallocArg2(FuncSummary summary, Instruction &I) {
+        void addDeallocArg2(const FuncSummary &summary, Instruction &I) {
             int argNumber=0;
             CallInst *call=dyn_cast<CallInst>(&I);
             Function *calledFunction = dyn_cast<Function>(call->getCalledFunction());
-            for(funcType t: summary.argTransforms) {
+            for(uint8_t t: summary.argTransforms) {
                 
-                if (t==deallocator) {
+                if (t & deallocatesArg) {
                     //errs()<<"\nDeallocator edges to be added for "<<summary.funcName->getName();
                     for (Value *A : call->args()) {
                         V argNode,ptrNode;
                         F flowEdge;
                         argNode.name=A;
                         argNode.vertexTy=ptr;
-                        if(HeapOFGraph.vertices.find(argNode) != HeapOFGraph.vertices.end()) {
-                            argNode=*(HeapOFGraph.vertices.find(argNode));
+                        if(HeapOFGraph.hasVertex(argNode.name)) {
+                            argNode=HeapOFGraph.getVertex(argNode.name);
                         }
                         Argument *formalArg = calledFunction->getArg(argNumber);
                         ptrNode.name=dyn_cast<Value>(formalArg);
@@ -2600,54 +3501,770 @@ namespace {
                         flowEdge.head=ptrNode;
                         flowEdge.tail=argNode;
                         annotateEdge(flowEdge,I);
-                        flowEdge.location=I.getDebugLoc();
+                        flowEdge.location=Locations.intern(I.getDebugLoc());
                         //errs()<<"Line number 20 "<<I.getDebugLoc().getLine();
-                        HeapOFGraph.flows.insert(flowEdge);
+                        HeapOFGraph.insertFlow(flowEdge);
                     }
                 }
                 argNumber++;
             }
         }
-        void addAllocArg2(FuncSummary summary, Instruction &I) {
+        void addAllocArg2(const FuncSummary &summary, Instruction &I) {
             int argNumber=0;
             CallInst *call=dyn_cast<CallInst>(&I);
             Function *calledFunction = dyn_cast<Function>(call->getCalledFunction());
-            for(funcType t: summary.argTransforms) {
-                if (t==allocator) {
+            for(uint8_t t: summary.argTransforms) {
+                if (t & allocatesArg) {
                     for (Value *A : call->args()) {
                         V argNode,ptrNode;
                         F flowEdge;
                         argNode.name=A;
                         argNode.vertexTy=ptr;
-                        if(HeapOFGraph.vertices.find(argNode) != HeapOFGraph.vertices.end()) {
-                            argNode=*(HeapOFGraph.vertices.find(argNode));
+                        if(HeapOFGraph.hasVertex(argNode.name)) {
+                            argNode=HeapOFGraph.getVertex(argNode.name);
                         Argument *formalArg = calledFunction->getArg(argNumber);
                         ptrNode.name=dyn_cast<Value>(formalArg);
                         ptrNode.vertexTy=ptr;
                         flowEdge.tail=ptrNode;
                         flowEdge.head=argNode;
                         annotateEdge(flowEdge,I);
-                        flowEdge.location=I.getDebugLoc();
-                        if(HeapOFGraph.flows.insert(flowEdge).second) {
+                        flowEdge.location=Locations.intern(I.getDebugLoc());
+                        if(HeapOFGraph.insertFlow(flowEdge)) {
                         }
                         }
                     }
-                } else if(t==deallocator){
+                } else if(t & deallocatesArg){
                     //errs()<<"\narg transform is a deallocator\n";
                 }
                 argNumber++;
             }
         }
+        std::vector<std::vector<Function*>> callGraphSCCs; //SCCs of defined functions, callees before callers
+        std::vector<std::vector<unsigned>> callerSCCs; //SCCs containing a call into each SCC
+        std::vector<bool> recursiveSCC;
+        DenseMap<Function*, unsigned> sccOfFunction;
+        /*
+        Function : traverseCallGraph(Module M)
+        Input : the module
+        Output : callGraphSCCs in bottom-up order of the call graph, with the caller SCCs of each SCC.
+        */
         void traverseCallGraph(Module &M) {
-            
+            CallGraph CG(M);
+            for(scc_iterator<CallGraph*> I = scc_begin(&CG); !I.isAtEnd(); ++I) {
+                std::vector<Function*> scc;
+                for(CallGraphNode *node : *I) {
+                    Function *F = node->getFunction();
+                    if(F && !F->isDeclaration()) {
+                        scc.push_back(F);
+                    }
+                }
+                if(scc.empty()) {
+                    continue;
+                }
+                for(Function *F : scc) {
+                    sccOfFunction[F] = callGraphSCCs.size();
+                }
+                recursiveSCC.push_back(I.hasCycle());
+                callGraphSCCs.push_back(scc);
+            }
+            callerSCCs.resize(callGraphSCCs.size());
+            for(unsigned caller = 0; caller < callGraphSCCs.size(); caller++) {
+                for(Function *F : callGraphSCCs[caller]) {
+                    for(auto &callRecord : *CG[F]) {
+                        Function *callee = callRecord.second->getFunction();
+                        if(!callee || !sccOfFunction.count(callee)) {
+                            continue;
+                        }
+                        unsigned calleeSCC = sccOfFunction[callee];
+                        std::vector<unsigned> &callers = callerSCCs[calleeSCC];
+                        if(calleeSCC != caller && (callers.empty() || callers.back() != caller)) {
+                            callers.push_back(caller);
+                        }
+                    }
+                }
+            }
+        }
+        struct SummaryState { //What a caller sees of a summary : its sets only grow, so sizes tell a change
+            funcType functionType;
+            SmallVector<uint8_t,4> argTransforms;
+            size_t globalAlloc, globalDealloc, returnValues;
+            bool operator == (const SummaryState &other) const {return functionType == other.functionType
+            && argTransforms == other.argTransforms && globalAlloc == other.globalAlloc && globalDealloc == other.globalDealloc && returnValues == other.returnValues;}
+            bool operator != (const SummaryState &other) const {return !(*this == other);}
+        };
+        std::vector<SummaryState> summaryStates(unsigned scc) {
+            std::vector<SummaryState> states;
+            for(Function *F : callGraphSCCs[scc]) {
+                SummaryState state = {noop, {}, 0, 0, 0};
+                if(FuncSummary *summary = summaryOf(F)) {
+                    state.functionType = summary->functionType;
+                    state.argTransforms = summary->argTransforms;
+                    state.globalAlloc = summary->globalAlloc.size();
+                    state.globalDealloc = summary->globalDealloc.size();
+                    state.returnValues = summary->returnValues.size();
+                }
+                states.push_back(state);
+            }
+            return states;
+        }
+        /*
+        Summary cache (-hofg-cache-dir). An entry holds what the first pass of generateFunctionSummary over a
+        function added to the graph and to its summary, with the answers the pass got from the graph as it was
+        before it. The entry is keyed by an MD5 of the function body and of the summaries of the functions it
+        calls. A hit whose recorded answers still hold is replayed instead of walking the function; a miss is
+        analysed as usual and recorded. Later passes over the function, e.g. when it is queued again top-down,
+        never use the cache.
+        Values are written as references that stay valid across runs : g:<global>, f:<function>,
+        a:<argument number>:<function> and i:<instruction number>:<function>.
+        */
+        unsigned summaryCacheHits = 0, summaryCacheMisses = 0;
+        struct ValueNumbering { //Instructions of the functions met so far in their order, per builder
+            DenseMap<Function*, std::vector<Instruction*>> instructions;
+            DenseMap<Instruction*, unsigned> instructionNumber;
+            const std::vector<Instruction*> &of(Function *F) {
+                auto it = instructions.find(F);
+                if(it != instructions.end()) {
+                    return it->second;
+                }
+                std::vector<Instruction*> &list = instructions[F];
+                for(BasicBlock &B : *F) {
+                    for(Instruction &I : B) {
+                        instructionNumber[&I] = list.size();
+                        list.push_back(&I);
+                    }
+                }
+                return list;
+            }
+        }valueNumbering;
+        static bool plainName(StringRef name) {
+            return !name.empty() && name.find_first_of(" \t\r\n") == StringRef::npos;
+        }
+        bool writeValueRef(Value *value, raw_ostream &os) {
+            if(GlobalValue *GV = dyn_cast<GlobalValue>(value)) {
+                if(!plainName(GV->getName())) {
+                    return false;
+                }
+                os<<(isa<Function>(GV) ? "f:" : "g:")<<GV->getName();
+                return true;
+            }
+            Function *F;
+            unsigned number;
+            char kind;
+            if(Argument *A = dyn_cast<Argument>(value)) {
+                F = A->getParent();
+                number = A->getArgNo();
+                kind = 'a';
+            } else if(Instruction *I = dyn_cast<Instruction>(value)) {
+                F = I->getFunction();
+                valueNumbering.of(F);
+                number = valueNumbering.instructionNumber[I];
+                kind = 'i';
+            } else {
+                return false;
+            }
+            if(!plainName(F->getName())) {
+                return false;
+            }
+            os<<kind<<':'<<number<<':'<<F->getName();
+            return true;
+        }
+        Value *readValueRef(Module &M, StringRef ref) {
+            if(ref.consume_front("g:")) {
+                return M.getNamedValue(ref);
+            }
+            if(ref.consume_front("f:")) {
+                return M.getFunction(ref);
+            }
+            if(ref.size() < 3 || ref[1] != ':') {
+                return nullptr;
+            }
+            char kind = ref[0];
+            StringRef numberText, name;
+            std::tie(numberText, name) = ref.drop_front(2).split(':');
+            unsigned number;
+            Function *F = M.getFunction(name);
+            if(numberText.getAsInteger(10, number) || !F || F->isDeclaration()) {
+                return nullptr;
+            }
+            if(kind == 'a') {
+                return number < F->arg_size() ? F->getArg(number) : nullptr;
+            }
+            const std::vector<Instruction*> &list = valueNumbering.of(F);
+            return (kind == 'i' && number < list.size()) ? list[number] : nullptr;
+        }
+        bool writeValueRefs(ArrayRef<Value*> values, StringRef tag, raw_ostream &os) { //One line per value, in a stable order
+            std::vector<std::string> refs;
+            for(Value *value : values) {
+                std::string ref;
+                raw_string_ostream refStream(ref);
+                if(!writeValueRef(value, refStream)) {
+                    return false;
+                }
+                refs.push_back(refStream.str());
+            }
+            std::sort(refs.begin(), refs.end());
+            for(const std::string &ref : refs) {
+                os<<tag<<' '<<ref<<'\n';
+            }
+            return true;
+        }
+        bool writeSummary(const FuncSummary &summary, raw_ostream &os) {
+            os<<"t "<<summary.functionType<<"\nl";
+            for(uint8_t mask : summary.argTransforms) {
+                os<<' '<<(unsigned)mask;
+            }
+            os<<'\n';
+            return writeValueRefs(summary.globalAlloc, "ga", os) && writeValueRefs(summary.globalDealloc, "gd", os)
+                && writeValueRefs(summary.returnValues, "r", os);
+        }
+        /*
+        Function : summaryCacheKey(F, key)
+        Output : hex MD5 of the body of F, with its operands as positions, and of the summaries of its callees.
+        False if something in it has no stable reference.
+        */
+        bool summaryCacheKey(Function &F, std::string &key) {
+            MD5 hash;
+            auto feed = [&hash](StringRef text) {
+                hash.update(text);
+                hash.update(StringRef("\0", 1));
+            };
+            std::string text;
+            raw_string_ostream os(text);
+            os<<"HOFGSUM 3 "<<F.getName()<<' '<<*F.getFunctionType()<<'\n'<<Callees.names;
+            DenseMap<BasicBlock*, unsigned> blockNumber;
+            for(BasicBlock &B : F) {
+                blockNumber[&B] = blockNumber.size();
+            }
+            valueNumbering.of(&F);
+            std::vector<Function*> callees;
+            for(BasicBlock &B : F) {
+                os<<"\nbb "<<B.getName();
+                for(Instruction &I : B) {
+                    os<<"\n"<<I.getOpcodeName()<<' '<<*I.getType();
+                    if(CmpInst *cmp = dyn_cast<CmpInst>(&I)) {
+                        os<<" p"<<cmp->getPredicate();
+                    }
+                    for(Value *operand : I.operands()) {
+                        if(Instruction *opIns = dyn_cast<Instruction>(operand)) {
+                            os<<" i"<<valueNumbering.instructionNumber[opIns];
+                        } else if(Argument *A = dyn_cast<Argument>(operand)) {
+                            os<<" a"<<A->getArgNo();
+                        } else if(BasicBlock *opBlock = dyn_cast<BasicBlock>(operand)) {
+                            os<<" b"<<blockNumber[opBlock];
+                        } else if(GlobalValue *GV = dyn_cast<GlobalValue>(operand)) {
+                            os<<" g"<<GV->getName();
+                        } else if(isa<MetadataAsValue>(operand)) {
+                            os<<" md";
+                        } else {
+                            os<<" "<<*operand;
+                        }
+                    }
+                    if(CallInst *call = dyn_cast<CallInst>(&I)) {
+                        Function *callee = call->getCalledFunction();
+                        if(callee && !callee->isDeclaration() && std::find(callees.begin(), callees.end(), callee) == callees.end()) {
+                            callees.push_back(callee);
+                        }
+                    }
+                }
+                feed(os.str());
+                text.clear();
+            }
+            for(Function *callee : callees) {
+                os<<"callee "<<callee->getName()<<'\n';
+                if(FuncSummary *summary = summaryOf(callee)) {
+                    os<<summary->generated<<'\n';
+                    if(!writeSummary(*summary, os)) {
+                        return false;
+                    }
+                }
+                feed(os.str());
+                text.clear();
+            }
+            MD5::MD5Result result;
+            hash.final(result);
+            key = result.digest().str().str();
+            return true;
+        }
+        bool writeSummaryCacheEntry(Function &F, const std::string &path, const PassRecord &record) {
+            const std::vector<Instruction*> &list = valueNumbering.of(&F);
+            DenseMap<LocId, unsigned> locationOwner; //first instruction of F at each location
+            for(unsigned n = 0; n < list.size(); n++) {
+                if(LocId loc = Locations.intern(list[n]->getDebugLoc())) {
+                    locationOwner.insert(std::make_pair(loc, n));
+                }
+            }
+            std::string text;
+            raw_string_ostream os(text);
+            os<<"HOFGSUM 3\n";
+            for(const VertexRead &read : record.vertexReads) {
+                os<<"V ";
+                if(!writeValueRef(read.name, os)) {
+                    return false;
+                }
+                os<<' '<<read.known<<' '<<read.vertexTy<<'\n';
+            }
+            for(const FlowRead &read : record.flowReads) {
+                os<<"E ";
+                if(!writeValueRef(read.tail, os)) {
+                    return false;
+                }
+                os<<' ';
+                if(!writeValueRef(read.head, os)) {
+                    return false;
+                }
+                os<<' '<<read.known<<'\n';
+            }
+            for(const V &vertex : record.vertices) {
+                os<<"v ";
+                if(!writeValueRef(vertex.name, os)) {
+                    return false;
+                }
+                os<<' '<<vertex.vertexTy<<'\n';
+            }
+            for(const struct F &flowEdge : record.flows) {
+                os<<"f ";
+                if(!writeValueRef(flowEdge.tail.name, os)) {
+                    return false;
+                }
+                os<<' '<<flowEdge.tail.vertexTy<<' ';
+                if(!writeValueRef(flowEdge.head.name, os)) {
+                    return false;
+                }
+                os<<' '<<flowEdge.head.vertexTy<<' ';
+                if(!flowEdge.location) {
+                    os<<'-';
+                } else {
+                    auto owner = locationOwner.find(flowEdge.location);
+                    if(owner == locationOwner.end()) {
+                        return false;
+                    }
+                    os<<owner->second;
+                }
+                for(Value *cond : Conditions.members(flowEdge.conditions)) {
+                    os<<' ';
+                    if(!writeValueRef(cond, os)) {
+                        return false;
+                    }
+                }
+                os<<'\n';
+            }
+            for(auto &missed : HeapOFGraph.missedLookups) {
+                if(std::find(missed.second.begin(), missed.second.end(), &F) != missed.second.end()) {
+                    os<<"m ";
+                    if(!writeValueRef(missed.first, os)) {
+                        return false;
+                    }
+                    os<<'\n';
+                }
+            }
+            FuncSummary *summary = summaryOf(&F);
+            if(!summary || !writeSummary(*summary, os)) {
+                return false;
+            }
+            os<<"end\n";
+            std::string tempPath = path + "." + utostr(get_threadid()) + ".tmp"; //renamed into place, readers never see half an entry
+            std::error_code EC;
+            {
+                raw_fd_ostream file(tempPath, EC, sys::fs::OF_None);
+                if(EC) {
+                    return false;
+                }
+                file<<os.str();
+            }
+            return !sys::fs::rename(tempPath, path);
+        }
+        /*
+        Function : replaySummaryCacheEntry(F, path)
+        Output : true if the entry exists, every graph answer it recorded still holds, and it was replayed :
+        its vertices and edges added to HeapOFGraph, its missed lookups recorded and the summary of F set.
+        */
+        bool replaySummaryCacheEntry(Function &F, const std::string &path) {
+            ErrorOr<std::unique_ptr<MemoryBuffer>> buffer = MemoryBuffer::getFile(path);
+            if(!buffer) {
+                return false;
+            }
+            Module &M = *F.getParent();
+            const std::vector<Instruction*> &list = valueNumbering.of(&F);
+            std::vector<V> vertices;
+            std::vector<struct F> flows;
+            std::vector<Value*> misses;
+            FuncSummary summary(&F);
+            bool complete = false;
+            StringRef rest = (*buffer)->getBuffer(), line;
+            std::tie(line, rest) = rest.split('\n');
+            if(line != "HOFGSUM 3") {
+                return false;
+            }
+            while(!rest.empty() && !complete) {
+                std::tie(line, rest) = rest.split('\n');
+                SmallVector<StringRef, 8> tokens;
+                line.split(tokens, ' ', -1, false);
+                if(tokens.empty()) {
+                    continue;
+                }
+                StringRef tag = tokens[0];
+                unsigned a = 0, b = 0;
+                if(tag == "end") {
+                    complete = true;
+                } else if(tag == "V" && tokens.size() == 4) {
+                    Value *name = readValueRef(M, tokens[1]);
+                    if(!name || tokens[2].getAsInteger(10, a) || tokens[3].getAsInteger(10, b)) {
+                        return false;
+                    }
+                    const V *known = HeapOFGraph.lookupVertex(name);
+                    if((known != nullptr) != (a != 0) || (known && known->vertexTy != (vertexType)b)) {
+                        return false;
+                    }
+                } else if(tag == "E" && tokens.size() == 4) {
+                    Value *tail = readValueRef(M, tokens[1]), *head = readValueRef(M, tokens[2]);
+                    if(!tail || !head || tokens[3].getAsInteger(10, a) || HeapOFGraph.knowsFlow(tail, head) != (a != 0)) {
+                        return false;
+                    }
+                } else if(tag == "v" && tokens.size() == 3) {
+                    V vertex;
+                    vertex.name = readValueRef(M, tokens[1]);
+                    if(!vertex.name || tokens[2].getAsInteger(10, a)) {
+                        return false;
+                    }
+                    vertex.vertexTy = (vertexType)a;
+                    vertices.push_back(vertex);
+                } else if(tag == "f" && tokens.size() >= 6) {
+                    struct F flowEdge;
+                    flowEdge.tail.name = readValueRef(M, tokens[1]);
+                    flowEdge.head.name = readValueRef(M, tokens[3]);
+                    if(!flowEdge.tail.name || !flowEdge.head.name || tokens[2].getAsInteger(10, a) || tokens[4].getAsInteger(10, b)) {
+                        return false;
+                    }
+                    flowEdge.tail.vertexTy = (vertexType)a;
+                    flowEdge.head.vertexTy = (vertexType)b;
+                    if(tokens[5] != "-") {
+                        if(tokens[5].getAsInteger(10, a) || a >= list.size()) {
+                            return false;
+                        }
+                        flowEdge.location = Locations.intern(list[a]->getDebugLoc());
+                    }
+                    std::vector<Value*> conds;
+                    for(size_t t = 6; t < tokens.size(); t++) {
+                        Value *cond = readValueRef(M, tokens[t]);
+                        if(!cond) {
+                            return false;
+                        }
+                        conds.push_back(cond);
+                    }
+                    std::sort(conds.begin(), conds.end());
+                    conds.erase(std::unique(conds.begin(), conds.end()), conds.end());
+                    flowEdge.conditions = Conditions.intern(conds);
+                    flows.push_back(flowEdge);
+                } else if(tag == "m" && tokens.size() == 2) {
+                    Value *name = readValueRef(M, tokens[1]);
+                    if(!name) {
+                        return false;
+                    }
+                    misses.push_back(name);
+                } else if(tag == "t" && tokens.size() == 2 && !tokens[1].getAsInteger(10, a)) {
+                    summary.functionType = (funcType)a;
+                } else if(tag == "l") {
+                    summary.argTransforms.clear(); //one mask per argument follows
+                    for(size_t t = 1; t < tokens.size(); t++) {
+                        if(tokens[t].getAsInteger(10, a)) {
+                            return false;
+                        }
+                        summary.argTransforms.push_back((uint8_t)a);
+                    }
+                    if(summary.argTransforms.size() != F.arg_size()) {
+                        return false;
+                    }
+                } else if((tag == "ga" || tag == "gd" || tag == "r") && tokens.size() == 2) {
+                    Value *value = readValueRef(M, tokens[1]);
+                    if(!value) {
+                        return false;
+                    }
+                    FuncSummary::addValue(tag == "ga" ? summary.globalAlloc : tag == "gd" ? summary.globalDealloc : summary.returnValues, value);
+                } else {
+                    return false;
+                }
+            }
+            FuncSummary *target = summaryOf(&F);
+            if(!complete || !target) {
+                return false;
+            }
+            for(const V &vertex : vertices) {
+                HeapOFGraph.addVertex(vertex);
+            }
+            for(const struct F &flowEdge : flows) {
+                HeapOFGraph.insertFlow(flowEdge);
+            }
+            for(Value *name : misses) {
+                SmallVector<Function*,2> &missedBy = HeapOFGraph.missedLookups[name];
+                if(std::find(missedBy.begin(), missedBy.end(), &F) == missedBy.end()) {
+                    missedBy.push_back(&F);
+                }
+            }
+            target->functionType = summary.functionType;
+            target->argTransforms = summary.argTransforms;
+            target->globalAlloc = summary.globalAlloc;
+            target->globalDealloc = summary.globalDealloc;
+            target->returnValues = summary.returnValues;
+            target->generated = true;
+            return true;
+        }
+        bool summariseThroughCache(Function &F) { //First pass over F, from the cache if it has the entry. True on a hit.
+            std::string key;
+            if(F.isDeclaration() || (calleeFlags(&F) & wrapperCallee) || !summaryCacheKey(F, key)) {
+                generateFunctionSummary(F);
+                return false;
+            }
+            SmallString<128> path(HOFGCacheDir);
+            sys::path::append(path, key + ".hofgsum");
+            if(replaySummaryCacheEntry(F, path.str().str())) {
+                ++NumSummaryCacheHits;
+                return true;
+            }
+            ++NumSummaryCacheMisses;
+            PassRecord record;
+            HeapOFGraph.record = &record;
+            generateFunctionSummary(F);
+            HeapOFGraph.record = nullptr;
+            if(record.cacheable) {
+                writeSummaryCacheEntry(F, path.str().str(), record);
+            }
+            return false;
+        }
+        /*
+        Function : summariseSCC(scc, builder)
+        Input : an SCC and the builder it is summarised on
+        Output : passes of generateFunctionSummary over the SCC until it is stable, in the graph of the builder.
+        An SCC is iterated only while a pass adds a vertex that one of its functions had looked up and missed, or,
+        for recursive SCCs, while its summaries change. SCCs of other functions that missed an added vertex are
+        left in requeue, e.g. a callee whose formal argument is created at a call site.
+        */
+        struct SCCResult {
+            int passes = 0;
+            unsigned cacheHits = 0, cacheMisses = 0;
+            std::vector<unsigned> requeue;
+        };
+        SCCResult summariseSCC(unsigned scc, HOFG &builder) {
+            HOFGraph &graph = builder.HeapOFGraph;
+            SCCResult result;
+            std::vector<unsigned> &requeue = result.requeue;
+            bool again;
+            do {
+                again = false;
+                VertexId firstNew = graph.numVertices();
+                std::vector<SummaryState> passStates = summaryStates(scc);
+                for(Function *F : callGraphSCCs[scc]) {
+                    if(!HOFGCacheDir.empty() && !summaryGenerated(*F)) { //only the first pass over a function goes through the cache
+                        if(builder.summariseThroughCache(*F)) {
+                            result.cacheHits++;
+                            continue;
+                        }
+                        result.cacheMisses++;
+                    } else {
+                        builder.generateFunctionSummary(*F);
+                    }
+                    result.passes++;
+                }
+                for(VertexId v = firstNew; v < graph.numVertices(); v++) {
+                    auto missed = graph.missedLookups.find(graph.vertex(v).name);
+                    if(missed == graph.missedLookups.end()) {
+                        continue;
+                    }
+                    for(Function *F : missed->second) {
+                        auto sccit = sccOfFunction.find(F);
+                        if(sccit == sccOfFunction.end()) {
+                        } else if(sccit->second == scc) {
+                            again = true;
+                        } else {
+                            requeue.push_back(sccit->second);
+                        }
+                    }
+                    graph.missedLookups.erase(missed);
+                }
+                if(recursiveSCC[scc] && summaryStates(scc) != passStates) {
+                    again = true;
+                }
+            } while(again);
+            return result;
+        }
+        /*
+        Function : summariseCallGraph()
+        Input : callGraphSCCs from traverseCallGraph
+        Output : HOFG and function summaries at their fixpoint. Returns the number of function passes made.
+        The SCCs are levelled, a level being one more than the highest level of the SCCs it calls. Queued SCCs
+        of the lowest level form a wave : they do not call each other, so each is summarised on its own builder,
+        in parallel on -hofg-threads workers. At the end of the wave the builders are merged into HeapOFGraph in
+        SCC order, so the result does not depend on the number of threads. Callers are queued again when a
+        summary of the SCC changed, and any SCC when a vertex it missed was added by the wave.
+        */
+        int summariseCallGraph() {
+            std::vector<unsigned> sccLevel(callGraphSCCs.size(), 0);
+            for(unsigned scc = 0; scc < callGraphSCCs.size(); scc++) { //callers come after their callees
+                for(unsigned caller : callerSCCs[scc]) {
+                    sccLevel[caller] = std::max(sccLevel[caller], sccLevel[scc] + 1);
+                }
+            }
+            std::set<std::pair<unsigned,unsigned>> worklist; //(level,scc)
+            for(unsigned scc = 0; scc < callGraphSCCs.size(); scc++) {
+                worklist.insert(std::make_pair(sccLevel[scc], scc));
+                for(Function *F : callGraphSCCs[scc]) { //the builders only find summaries, they do not insert them
+                    if(calleeFlags(F) & wrapperCallee) {
+                        continue;
+                    }
+                    allFuncSummaries.insert(F);
+                }
+            }
+            if(!HOFGCacheDir.empty()) {
+                sys::fs::create_directories(HOFGCacheDir);
+            }
+            WorkStealingPool pool(numThreads());
+            std::vector<HOFGraph> spareGraphs; //cleared overlays of merged builders
+            int passes = 0;
+            while(!worklist.empty()) {
+                if(moduleBudget.deadlinePassed()) { //The leak analysis leaves every walk inconclusive from here
+                    moduleBudget.exhausted = deadlineBudget;
+                    log<<"\nThe deadline of -hofg-deadline passed : the function summaries are incomplete\n";
+                    break;
+                }
+                unsigned level = worklist.begin()->first;
+                std::vector<unsigned> wave;
+                while(!worklist.empty() && worklist.begin()->first == level) {
+                    wave.push_back(worklist.begin()->second);
+                    worklist.erase(worklist.begin());
+                }
+                std::vector<std::vector<SummaryState>> entryStates;
+                std::vector<std::unique_ptr<HOFG>> builders;
+                for(unsigned scc : wave) {
+                    entryStates.push_back(summaryStates(scc));
+                    builders.emplace_back(new HOFG(*this));
+                    if(!spareGraphs.empty()) {
+                        builders.back()->HeapOFGraph = std::move(spareGraphs.back());
+                        builders.back()->HeapOFGraph.base = &HeapOFGraph;
+                        spareGraphs.pop_back();
+                    }
+                }
+                std::vector<SCCResult> results(wave.size());
+                pool.run(wave.size(), [&](unsigned worker, unsigned i) {
+                    results[i] = summariseSCC(wave[i], *builders[i]);
+                });
+                VertexId firstNew = HeapOFGraph.numVertices();
+                for(size_t i = 0; i < wave.size(); i++) {
+                    HeapOFGraph.merge(builders[i]->HeapOFGraph);
+                    builders[i]->HeapOFGraph.clear();
+                    spareGraphs.push_back(std::move(builders[i]->HeapOFGraph));
+                    builders[i].reset();
+                    passes += results[i].passes;
+                    summaryCacheHits += results[i].cacheHits;
+                    summaryCacheMisses += results[i].cacheMisses;
+                    NumSummaryCacheHits += results[i].cacheHits;
+                    NumSummaryCacheMisses += results[i].cacheMisses;
+                    for(unsigned scc : results[i].requeue) {
+                        worklist.insert(std::make_pair(sccLevel[scc], scc));
+                    }
+                    if(summaryStates(wave[i]) != entryStates[i]) {
+                        for(unsigned caller : callerSCCs[wave[i]]) {
+                            worklist.insert(std::make_pair(sccLevel[caller], caller));
+                        }
+                    }
+                }
+                for(VertexId v = firstNew; v < HeapOFGraph.numVertices(); v++) {
+                    auto missed = HeapOFGraph.missedLookups.find(HeapOFGraph.vertex(v).name);
+                    if(missed == HeapOFGraph.missedLookups.end()) {
+                        continue;
+                    }
+                    for(Function *F : missed->second) {
+                        auto sccit = sccOfFunction.find(F);
+                        if(sccit != sccOfFunction.end()) {
+                            worklist.insert(std::make_pair(sccLevel[sccit->second], sccit->second));
+                        }
+                    }
+                    HeapOFGraph.missedLookups.erase(missed);
+                }
+            }
+            return passes;
+        }
+        void markSummarisedFunctions() {
+            for(const FuncSummary &summary : allFuncSummaries) {
+                if(summary.generated) {
+                    LLVMContext& C=summary.funcName->getContext();
+                    MDNode* N=MDNode::get(C, MDString::get(C,"summary generated"));
+                    summary.funcName->setMetadata("summary",N);
+                }
+            }
         }
         void getAnalysisUsage(AnalysisUsage &AU) const override {
           AU.setPreservesAll();
         }
     };
+    /*
+    New pass manager : HOFGAnalysis builds the HOFG of a module, the function summaries and the leak verdicts
+    once. The analysis manager keeps the result until a pass does not preserve HOFGAnalysis, so the passes that
+    query it share one build. print<hofg> reports the leaks from the result, as the legacy pass does.
+    */
+    class HOFGAnalysis : public AnalysisInfoMixin<HOFGAnalysis> {
+        friend AnalysisInfoMixin<HOFGAnalysis>;
+        static AnalysisKey Key;
+    public:
+        struct Result {
+            std::unique_ptr<HOFG> hofg; //graph, summaries and verdicts in the fields of a pass object
+            bool valid = false; //analyseModule succeeded, its log says why otherwise
+            bool invalidate(Module &M, const PreservedAnalyses &PA, ModuleAnalysisManager::Invalidator &) {
+                PreservedAnalyses::PreservedAnalysisChecker PAC = PA.getChecker<HOFGAnalysis>();
+                return !(PAC.preserved() || PAC.preservedSet<AllAnalysesOn<Module>>());
+            }
+        };
+        Result run(Module &M, ModuleAnalysisManager &) {
+            Result result;
+            result.hofg.reset(new HOFG());
+            result.valid = result.hofg->analyseModule(M, false);
+            return result;
+        }
+    };
+    class HOFGPrinterPass : public PassInfoMixin<HOFGPrinterPass> {
+        raw_ostream &OS;
+    public:
+        explicit HOFGPrinterPass(raw_ostream &OS) : OS(OS) {}
+        PreservedAnalyses run(Module &M, ModuleAnalysisManager &MAM) {
+            HOFGAnalysis::Result &result = MAM.getResult<HOFGAnalysis>(M);
+            HOFG &hofg = *result.hofg;
+            hofg.printAnalysisLog(errs());
+            if(!result.valid) { //Only the error in the log, as the legacy pass returns early
+                return PreservedAnalyses::all();
+            }
+            hofg.printLeakReports(OS, outs());
+            hofg.writeStats(M);
+            return PreservedAnalyses::all();
+        }
+    };
 }
 
 char HOFG::ID = 0;
+constexpr uint32_t HOFG::InvalidId;
+constexpr HOFG::VertexId HOFG::ManyOrigins;
 static RegisterPass<HOFG> X("-analyseHOFG", "HOFG generate and analyse errors on module");
+AnalysisKey HOFGAnalysis::Key;
+
+/*
+Plugin entry of the new pass manager, for opt -load-pass-plugin :
+the analysis is hofg (require<hofg>, invalidate<hofg>) and print<hofg> prints its leak reports.
+*/
+extern "C" LLVM_ATTRIBUTE_WEAK PassPluginLibraryInfo llvmGetPassPluginInfo() {
+    return {LLVM_PLUGIN_API_VERSION, "HOFG", LLVM_VERSION_STRING, [](PassBuilder &PB) {
+        PB.registerAnalysisRegistrationCallback([](ModuleAnalysisManager &MAM) {
+            MAM.registerPass([] {return HOFGAnalysis();});
+        });
+        PB.registerPipelineParsingCallback([](StringRef Name, ModulePassManager &MPM, ArrayRef<PassBuilder::PipelineElement>) {
+            if(Name == "print<hofg>") {
+                MPM.addPass(HOFGPrinterPass(errs()));
+            } else if(Name == "require<hofg>") {
+                MPM.addPass(RequireAnalysisPass<HOFGAnalysis, Module>());
+            } else if(Name == "invalidate<hofg>") {
+                MPM.addPass(InvalidateAnalysisPass<HOFGAnalysis>());
+            } else {
+                return false;
+            }
+            return true;
+        });
+    }};
+}
 
 
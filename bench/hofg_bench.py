@@ -0,0 +1,179 @@
+#!/usr/bin/env python3
+"""Scaling benchmark of the HOFG pass over synthetic modules.
+
+Each sweep varies one shape parameter of hofg_gen.py with the others at
+their defaults. Every point is generated, run through
+
+  opt -enable-new-pm=0 -load <plugin> ---analyseHOFG -hofg-stats=<json>
+
+and recorded with the wall time and peak RSS of opt, and the phase times,
+peak memory and counters the pass writes with -hofg-stats: the function
+passes of the summary fixpoint (NumSummaryPasses), the graph the handlers
+built and, with --witness-paths, the paths generated and pruned.
+
+The copies sweep of the defaults is the copy ladder of hofg_gen.py past
+100k flow edges, without the witness paths: its time is the construction
+of the graph and the traversals of canonicalisation and the leak analysis.
+
+With --stress the sweep is instead the copy ladder of hofg_gen.py, up to
+a million copies, run with -hofg-witness-paths and no path budget, so the
+whole chain is one path the enumeration walks and prints.
+
+The result is one JSON document, so two builds of the plugin can be
+compared point by point:
+
+  hofg_bench.py --opt bin/opt --plugin lib/LLVMHOFG.so -o before.json
+  hofg_bench.py --opt bin/opt --plugin lib/LLVMHOFG.so \\
+      --sweep funcs=50,100,200,400 --sweep chain=4,16,64 -o after.json
+"""
+
+import argparse
+import json
+import os
+import subprocess
+import sys
+import tempfile
+import time
+
+sys.path.insert(0, os.path.dirname(os.path.abspath(__file__)))
+import hofg_gen  # noqa: E402
+
+DEFAULT_SWEEPS = [
+    ('funcs', [100, 200, 400, 800, 1600]),
+    ('chain', [8, 32, 128, 512]),
+    ('fanout', [8, 32, 128]),
+    ('sites', [8, 32, 128]),
+    ('sccs', [4, 16, 64]),
+    ('globals', [8, 64, 256]),
+    ('copies', [25000, 100000, 200000]),
+]
+
+STRESS_SWEEPS = [
+    ('copies', [10000, 100000, 1000000]),
+]
+
+
+def parse_sweep(text):
+    name, _, values = text.partition('=')
+    if name not in hofg_gen.SHAPE_DEFAULTS or not values:
+        raise argparse.ArgumentTypeError('expected <%s>=v1,v2,...' % '|'.join(hofg_gen.SHAPE_DEFAULTS))
+    return name, [int(v) for v in values.split(',')]
+
+
+def run_opt(args, module, stats):
+    """Runs the pass on module. Returns (status, wall seconds, peak RSS bytes of opt)."""
+    command = [args.opt, '-enable-new-pm=0', '-load', args.plugin, '---analyseHOFG',
+               '-hofg-stats=' + stats, '-hofg-threads=%d' % args.threads, module, '-o', os.devnull]
+    if args.witness_paths:
+        command.append('-hofg-witness-paths')
+    if args.stress:
+        command += ['-hofg-witness-paths', '-hofg-source-paths=0']
+    start = time.monotonic()
+    proc = subprocess.Popen(command, stdout=subprocess.DEVNULL, stderr=subprocess.DEVNULL)
+    timed_out = False
+    while True:  # os.wait4 rather than proc.wait, for the rusage of this child alone
+        pid, status, usage = os.wait4(proc.pid, os.WNOHANG)
+        if pid:
+            break
+        if time.monotonic() - start > args.timeout:
+            proc.kill()
+            timed_out = True
+            pid, status, usage = os.wait4(proc.pid, 0)
+            break
+        time.sleep(0.01)
+    wall = time.monotonic() - start
+    proc.returncode = -os.WTERMSIG(status) if os.WIFSIGNALED(status) else os.WEXITSTATUS(status)
+    rss = usage.ru_maxrss * (1 if sys.platform == 'darwin' else 1024)
+    if timed_out:
+        return 'timeout', wall, rss
+    return ('ok' if proc.returncode == 0 else 'error'), wall, rss
+
+
+def run_point(args, workdir, sweep, value):
+    shape = dict(hofg_gen.SHAPE_DEFAULTS)
+    shape[sweep] = value
+    module = os.path.join(workdir, '%s-%d.ll' % (sweep, value))
+    with open(module, 'w') as f:
+        f.write(hofg_gen.generate(argparse.Namespace(**shape)))
+    record = {'sweep': sweep, 'value': value, 'shape': shape, 'runs': []}
+    best = None
+    for _ in range(args.repeat):
+        stats = os.path.join(workdir, 'stats.json')
+        if os.path.exists(stats):
+            os.remove(stats)
+        status, wall, rss = run_opt(args, module, stats)
+        run = {'status': status, 'wallSeconds': wall, 'peakRSSBytes': rss}
+        if status == 'ok' and os.path.exists(stats):
+            with open(stats) as f:
+                reported = json.load(f)
+            run['phases'] = reported['phases']
+            run['counters'] = reported['counters']
+        record['runs'].append(run)
+        if status != 'ok':
+            break
+        if best is None or wall < best['wallSeconds']:
+            best = run
+    record['status'] = record['runs'][-1]['status']
+    if best is not None:  # the fastest run stands for the point
+        record.update({k: v for k, v in best.items() if k != 'status'})
+    if not args.keep:
+        os.remove(module)
+    return record
+
+
+def summary_line(record):
+    counters = record.get('counters', {})
+    return '%-8s %6d  %-7s %9.3fs %8.1f MiB  passes %-6s paths %s' % (
+        record['sweep'], record['value'], record['status'], record.get('wallSeconds', 0),
+        record.get('peakRSSBytes', 0) / 2.0 ** 20, counters.get('NumSummaryPasses', '-'),
+        counters.get('NumPathsGenerated', '-'))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0],
+                                     formatter_class=argparse.RawDescriptionHelpFormatter, epilog=__doc__)
+    parser.add_argument('--opt', default='opt', help='opt binary (default: opt on PATH)')
+    parser.add_argument('--plugin', required=True, help='the HOFG plugin, LLVMHOFG.so')
+    parser.add_argument('--sweep', action='append', type=parse_sweep,
+                        help='<param>=v1,v2,... to sweep instead of the default sweeps; repeatable')
+    parser.add_argument('--repeat', type=int, default=3, help='runs per point, the fastest is kept (default 3)')
+    parser.add_argument('--timeout', type=float, default=600, help='seconds per run (default 600)')
+    parser.add_argument('--threads', type=int, default=1, help='-hofg-threads of the runs (default 1)')
+    parser.add_argument('--witness-paths', action='store_true',
+                        help='run with -hofg-witness-paths, so the path enumeration is measured')
+    parser.add_argument('--stress', action='store_true',
+                        help='sweep the copy ladder up to a million edges instead, with the witness paths')
+    parser.add_argument('--keep', metavar='DIR', help='keep the generated modules in DIR')
+    parser.add_argument('-o', '--output', help='write the JSON here instead of stdout')
+    args = parser.parse_args()
+
+    sweeps = args.sweep or (STRESS_SWEEPS if args.stress else DEFAULT_SWEEPS)
+    workdir = args.keep or tempfile.mkdtemp(prefix='hofg-bench-')
+    os.makedirs(workdir, exist_ok=True)
+    points = []
+    for sweep, values in sweeps:
+        for value in values:
+            record = run_point(args, workdir, sweep, value)
+            print(summary_line(record), file=sys.stderr)
+            points.append(record)
+            if record['status'] == 'timeout':  # larger points of this sweep would time out too
+                break
+    stats = os.path.join(workdir, 'stats.json')
+    if os.path.exists(stats):
+        os.remove(stats)
+    if not args.keep:
+        os.rmdir(workdir)
+
+    result = {'opt': args.opt, 'plugin': args.plugin, 'threads': args.threads,
+              'witnessPaths': args.witness_paths or args.stress, 'stress': args.stress, 'repeat': args.repeat, 'points': points}
+    text = json.dumps(result, indent=2) + '\n'
+    if args.output:
+        with open(args.output, 'w') as f:
+            f.write(text)
+    else:
+        sys.stdout.write(text)
+    return 0 if all(p['status'] == 'ok' for p in points) else 1
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,209 @@
+#!/usr/bin/env python3
+"""Generate a synthetic LLVM IR module for benchmarking the HOFG pass.
+
+The module is textual IR with typed pointers and debug locations, in the
+shape clang -O0 emits, built from these parts:
+
+  --chain    allocator wrappers wrap0..wrapN-1, each returning the
+             allocation of the one below, wrap0 calling malloc
+  --sccs     pairs of mutually recursive allocators ra<k>/rb<k>
+  --globals  global pointers the entry functions store into
+  --funcs    entry functions f0..fN-1, each with
+  --sites    malloc sites, every one copied through
+  --fanout   allocas by load/store, freed on one branch directly, on the
+             other through the release wrapper, and joined by a PHI
+  --copies   a function ladder whose allocation is copied down a chain of
+             that many bitcasts, every eighth a PHI, and left unfreed : one
+             path with an edge per copy, for the stress run of hofg_bench.py
+
+Usage: hofg_gen.py [--funcs N] [--chain N] ... > module.ll
+"""
+
+import argparse
+import sys
+
+
+class Module:
+    def __init__(self):
+        self.lines = []
+        self.metadata = []
+        self.next_id = 100
+        self.line = 1
+
+    def new_md(self, text):
+        md_id = self.next_id
+        self.next_id += 1
+        self.metadata.append('!%d = %s' % (md_id, text))
+        return md_id
+
+    def subprogram(self, name):
+        return self.new_md('distinct !DISubprogram(name: "%s", scope: !3, file: !3, '
+                           'line: %d, type: !9, unit: !2)' % (name, self.line))
+
+    def loc(self, scope):
+        """A new source line in scope, so every site reports its own line."""
+        self.line += 1
+        return self.new_md('!DILocation(line: %d, column: 3, scope: !%d)' % (self.line, scope))
+
+
+def emit_chain(m, depth):
+    for k in range(depth):
+        sp = m.subprogram('wrap%d' % k)
+        l = m.loc(sp)
+        m.lines += ['define i32* @wrap%d() !dbg !%d {' % (k, sp), 'entry:']
+        if k == 0:
+            m.lines += ['  %%c = call i8* @malloc(i64 4), !dbg !%d' % l,
+                        '  %%r = bitcast i8* %%c to i32*, !dbg !%d' % l]
+        else:
+            m.lines += ['  %%r = call i32* @wrap%d(), !dbg !%d' % (k - 1, l)]
+        m.lines += ['  ret i32* %%r, !dbg !%d' % l, '}']
+
+
+def emit_release(m):
+    sp = m.subprogram('release')
+    l = m.loc(sp)
+    m.lines += ['define void @release(i32* %%p) !dbg !%d {' % sp, 'entry:',
+                '  %%b = bitcast i32* %%p to i8*, !dbg !%d' % l,
+                '  call void @free(i8* %%b), !dbg !%d' % l,
+                '  ret void, !dbg !%d' % l, '}']
+
+
+def emit_sccs(m, sccs):
+    for s in range(sccs):
+        for me, other in (('ra%d' % s, 'rb%d' % s), ('rb%d' % s, 'ra%d' % s)):
+            sp = m.subprogram(me)
+            l = m.loc(sp)
+            m.lines += ['define i32* @%s(i32 %%n) !dbg !%d {' % (me, sp), 'entry:',
+                        '  %%t = icmp sgt i32 %%n, 0, !dbg !%d' % l,
+                        '  br i1 %%t, label %%rec, label %%base, !dbg !%d' % l,
+                        'rec:',
+                        '  %%m = sub i32 %%n, 1, !dbg !%d' % l,
+                        '  %%x = call i32* @%s(i32 %%m), !dbg !%d' % (other, l),
+                        '  br label %%done, !dbg !%d' % l,
+                        'base:',
+                        '  %%c = call i8* @malloc(i64 4), !dbg !%d' % l,
+                        '  %%y = bitcast i8* %%c to i32*, !dbg !%d' % l,
+                        '  br label %%done, !dbg !%d' % l,
+                        'done:',
+                        '  %%r = phi i32* [ %%x, %%rec ], [ %%y, %%base ], !dbg !%d' % l,
+                        '  ret i32* %%r, !dbg !%d' % l, '}']
+
+
+def emit_ladder(m, copies):
+    sp = m.subprogram('ladder')
+    l = m.loc(sp)
+    body = ['define void @ladder() !dbg !%d {' % sp, 'entry:',
+            '  %%c0 = call i8* @malloc(i64 4), !dbg !%d' % l]
+    block = 'entry'
+    for k in range(1, copies + 1):
+        if k % 8 == 0:  # a PHI of one incoming value, in a block of its own
+            body += ['  br label %%b%d, !dbg !%d' % (k, l), 'b%d:' % k,
+                     '  %%c%d = phi %s [ %%c%d, %%%s ], !dbg !%d' % (k, ladder_type(k - 1), k - 1, block, l)]
+            block = 'b%d' % k
+        else:
+            body.append('  %%c%d = bitcast %s %%c%d to %s, !dbg !%d'
+                        % (k, ladder_type(k - 1), k - 1, ladder_type(k), l))
+    body += ['  ret void, !dbg !%d' % l, '}']
+    m.lines += body
+
+
+def ladder_type(k):
+    """Type of copy k of the ladder : the bitcasts alternate i8* and i32*, a PHI keeps the type."""
+    return 'i8*' if (k - k // 8) % 2 == 0 else 'i32*'
+
+
+def emit_entry(m, f, args):
+    sp = m.subprogram('f%d' % f)
+    body = ['define void @f%d(i32 %%c) !dbg !%d {' % (f, sp), 'entry:']
+    body.append('  %%tb = icmp ne i32 %%c, 0, !dbg !%d' % m.loc(sp))
+    for s in range(args.sites):
+        l = m.loc(sp)
+        body += ['  %%s%d = alloca i32*, align 8' % s,
+                 '  %%m%d = call i8* @malloc(i64 4), !dbg !%d' % (s, l),
+                 '  %%p%d = bitcast i8* %%m%d to i32*, !dbg !%d' % (s, s, l),
+                 '  store i32* %%p%d, i32** %%s%d, align 8, !dbg !%d' % (s, s, l)]
+        for o in range(args.fanout):
+            l = m.loc(sp)
+            body += ['  %%a%d_%d = alloca i32*, align 8' % (s, o),
+                     '  %%l%d_%d = load i32*, i32** %%s%d, align 8, !dbg !%d' % (s, o, s, l),
+                     '  store i32* %%l%d_%d, i32** %%a%d_%d, align 8, !dbg !%d' % (s, o, s, o, l)]
+    l = m.loc(sp)
+    wrapped = args.chain > 0
+    if wrapped:
+        body += ['  %%w = call i32* @wrap%d(), !dbg !%d' % (args.chain - 1, l),
+                 '  %ws = alloca i32*, align 8',
+                 '  store i32* %%w, i32** %%ws, align 8, !dbg !%d' % l]
+    body += ['  br i1 %%tb, label %%then, label %%else, !dbg !%d' % l, 'then:']
+    for s in range(args.sites):
+        if s % 3 == 2:  # left allocated on this branch
+            continue
+        l = m.loc(sp)
+        last = ('%%a%d_%d' % (s, args.fanout - 1)) if args.fanout else ('%%s%d' % s)
+        body += ['  %%x%d = load i32*, i32** %s, align 8, !dbg !%d' % (s, last, l),
+                 '  %%y%d = bitcast i32* %%x%d to i8*, !dbg !%d' % (s, s, l),
+                 '  call void @free(i8* %%y%d), !dbg !%d' % (s, l)]
+    body += ['  br label %%join, !dbg !%d' % m.loc(sp), 'else:']
+    for s in range(0, args.sites, 3):
+        l = m.loc(sp)
+        body += ['  %%e%d = load i32*, i32** %%s%d, align 8, !dbg !%d' % (s, s, l),
+                 '  call void @release(i32* %%e%d), !dbg !%d' % (s, l)]
+    body += ['  br label %%join, !dbg !%d' % m.loc(sp), 'join:']
+    l = m.loc(sp)
+    if args.sites and wrapped:
+        body.append('  %%ph = phi i32* [ %%p0, %%then ], [ %%w, %%else ], !dbg !%d' % l)
+        if args.globals:
+            body.append('  store i32* %%ph, i32** @g%d, align 8, !dbg !%d' % (f % args.globals, l))
+    if args.sccs:
+        body.append('  %%rr = call i32* @ra%d(i32 %%c), !dbg !%d' % (f % args.sccs, l))
+    body += ['  ret void, !dbg !%d' % l, '}']
+    m.lines += body
+
+
+def generate(args):
+    m = Module()
+    m.lines += ['target triple = "x86_64-pc-linux-gnu"',
+                'declare i8* @malloc(i64)',
+                'declare void @free(i8*)']
+    for g in range(args.globals):
+        m.lines.append('@g%d = global i32* null, align 8' % g)
+    emit_chain(m, args.chain)
+    emit_release(m)
+    emit_sccs(m, args.sccs)
+    if args.copies:
+        emit_ladder(m, args.copies)
+    for f in range(args.funcs):
+        emit_entry(m, f, args)
+    m.lines += ['!llvm.dbg.cu = !{!2}',
+                '!llvm.module.flags = !{!7}',
+                '!2 = distinct !DICompileUnit(language: DW_LANG_C99, file: !3, producer: "hofg_gen", '
+                'isOptimized: false, runtimeVersion: 0, emissionKind: FullDebug)',
+                '!3 = !DIFile(filename: "gen.c", directory: "/tmp")',
+                '!7 = !{i32 2, !"Debug Info Version", i32 3}',
+                '!9 = !DISubroutineType(types: !{null})']
+    return '\n'.join(m.lines + m.metadata) + '\n'
+
+
+SHAPE_DEFAULTS = {'funcs': 10, 'chain': 3, 'fanout': 3, 'sites': 2, 'sccs': 1, 'globals': 2, 'copies': 0}
+
+
+def add_shape_arguments(parser):
+    for name, default in SHAPE_DEFAULTS.items():
+        parser.add_argument('--' + name, type=int, default=default,
+                            help='default %d' % default)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    add_shape_arguments(parser)
+    parser.add_argument('-o', '--output', help='write the module here instead of stdout')
+    args = parser.parse_args()
+    text = generate(args)
+    if args.output:
+        with open(args.output, 'w') as f:
+            f.write(text)
+    else:
+        sys.stdout.write(text)
+
+
+if __name__ == '__main__':
+    main()